@@ -13,15 +13,17 @@ namespace rtw {
 	* AABB Class
 	* aka
 	* Bounding Box for the BVH
+	* Templated on the scalar type, aabb is the 'real' version
 	*/
-	class aabb {
+	template <typename T>
+	class basic_aabb {
 	public:
 
 		// Side lengths
-		Interval x, y, z;
+		basic_interval<T> x, y, z;
 
 		// Default Consructor
-		aabb();
+		basic_aabb();
 
 		/**
 		* Interval/Side Constructor
@@ -32,7 +34,7 @@ namespace rtw {
 		* @param y	Second side of the box
 		* @param z	Third and final side of the box
 		*/
-		aabb(const Interval& x, const Interval& y, const Interval& z);
+		basic_aabb(const basic_interval<T>& x, const basic_interval<T>& y, const basic_interval<T>& z);
 
 		/**
 		* Point Constructor
@@ -43,7 +45,7 @@ namespace rtw {
 		* @param a	First point
 		* @param b	Second point
 		*/
-		aabb(const point3& a, const point3& b);
+		basic_aabb(const basic_vec3<T>& a, const basic_vec3<T>& b);
 
 		/**
 		* Union Constructor
@@ -53,14 +55,14 @@ namespace rtw {
 		* @param box0	First Box
 		* @param box1	Second Box
 		*/
-		aabb(const aabb& box0, const aabb& box1);
+		basic_aabb(const basic_aabb& box0, const basic_aabb& box1);
 
 		/**
 		* Interval / "Side Length" of Axis
 		* 
 		* @param n	Axis
 		*/
-		const Interval& axis_interval(int n) const;
+		const basic_interval<T>& axis_interval(int n) const;
 	
 		/**
 		* Hit
@@ -70,18 +72,46 @@ namespace rtw {
 		* 
 		* @return Whether the box has been hit
 		*/
-		bool hit(const ray& r, Interval ray_t) const;
+		bool hit(const basic_ray<T>& r, basic_interval<T> ray_t) const;
 
 		/**
 		* Longest Axis (index)
 		*/
 		int longest_axis() const;
 
+		/**
+		* Surface Area
+		* Used as the cost estimate when building/editing trees
+		*/
+		T surface_area() const;
+
+		/**
+		* Contains Box
+		* 
+		* @param other	Box to check
+		* 
+		* @return Whether other fits entirely inside this box
+		*/
+		bool contains(const basic_aabb& other) const;
+
+		/**
+		* Lerp
+		* Linear interpolation of every side, for boxes keyed over time
+		* 
+		* @param box0	Box at f = 0
+		* @param box1	Box at f = 1
+		* @param f		How far from box0 to box1
+		* 
+		* @return The interpolated box
+		*/
+		static basic_aabb lerp(const basic_aabb& box0, const basic_aabb& box1, T f);
+
 		// Useful bounding boxes
-		static const aabb empty, universe;
+		static const basic_aabb empty, universe;
 	};
 
-	
+	// Render path box
+	using aabb = basic_aabb<real>;
 
 }
 
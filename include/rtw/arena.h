@@ -0,0 +1,113 @@
+// arena.h - Declaration of the Arena class
+// Ethan Rudy
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Arena class
+	*
+	* Bump allocator for things that live exactly as long as the scene
+	* (materials, objects, ...). Objects are placed one after another in
+	* big blocks, in the order they're created, so things built together
+	* sit together in memory, with no per object heap header or shared_ptr
+	* control block between them.
+	*
+	* Nothing is freed on its own, release() (or the destructor) frees
+	* every block at once. Objects that need a destructor get one entry
+	* in a list that's run (in reverse) first, trivially destructible
+	* ones cost nothing at all to release.
+	*
+	* Not thread safe, fill it before the span threads start.
+	*/
+	class Arena {
+	public:
+
+		// Default block size, anything bigger gets a block of its own
+		static const size_t BLOCK_SIZE = 64 * 1024;
+
+		/**
+		* Default Constructor
+		*/
+		Arena();
+
+		/**
+		* Destructor
+		* Same as release()
+		*/
+		~Arena();
+
+		// Objects point into the blocks, so no copying them around
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		/**
+		* Allocate
+		* Raw memory, nothing is constructed
+		*
+		* @param size	Bytes
+		* @param align	Alignment, a power of 2
+		*
+		* @return Pointer to the memory, valid until release()
+		*/
+		void* allocate(size_t size, size_t align);
+
+		/**
+		* Create
+		* Constructs a T in the arena
+		*
+		* @param args	T's constructor arguments
+		*
+		* @return Pointer to the new T, valid until release()
+		*/
+		template <typename T, typename... Args>
+		T* create(Args&&... args) {
+			T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+			if (!std::is_trivially_destructible<T>::value) {
+				dtors.push_back({ object, [](void* p) { static_cast<T*>(p)->~T(); } });
+			}
+
+			return object;
+		}
+
+		/**
+		* Release
+		* Destroys every object and frees every block
+		*/
+		void release();
+
+		/**
+		* Used
+		*
+		* @return Bytes handed out so far (alignment padding included)
+		*/
+		size_t used() const;
+
+	private:
+		struct block {
+			char* data;
+			size_t size;
+			size_t used;
+		};
+
+		struct dtor_entry {
+			void* object;
+			void (*destroy)(void*);
+		};
+
+		std::vector<block> blocks;
+		std::vector<dtor_entry> dtors;
+	};
+
+}
+
+#endif // !ARENA_H
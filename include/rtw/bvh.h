@@ -46,6 +46,23 @@ namespace rtw {
 		*/
 		bool hit(const ray& r, Interval ray_t, hit_record& rec) const override;
 
+		/**
+		* Intersect
+		* 
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param info	Closest hit
+		*/
+		bool intersect(const ray& r, Interval ray_t, hit_info& info) const override;
+
+		/**
+		* Occluded
+		* 
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		*/
+		bool occluded(const ray& r, Interval ray_t) const override;
+
 		/**
 		* Bound Box
 		* 
@@ -5,12 +5,18 @@
 #define CAMERA_H
 
 #include "consts.hpp"
+#include "denoiser.h"
 #include "hittable_list.h"
 #include "vec3.hpp"
 #include "ray.h"
 #include "interval.h"
 #include "hittable.hpp"
 #include "material.hpp"
+#include "material_table.h"
+#include "path_guide.h"
+#include "ray_packet.h"
+#include "sampler.h"
+#include "scene.h"
 
 namespace rtw {
 	
@@ -25,6 +31,15 @@ namespace rtw {
 		int samples;
 		int max_depth;
 
+		// Bounces before Russian roulette can end a path early
+		int roulette_depth = 3;
+
+		// Where every sample's random numbers come from (see sampler.h)
+		// Same seed, same image, however the tiles get split between threads,
+		// path guiding included (see path_guide.h)
+		sampler_type sampling = sampler_type::sobol;
+		std::uint32_t seed = 0;
+
 		// Position and FOV
 		double  vfov = 90;
 		point3 lookfrom = point3(0, 0, 0);
@@ -35,6 +50,26 @@ namespace rtw {
 		double defocus_angle = 0;
 		double focus_dist = 10;
 
+		// Engine, wavefront traces batches of paths in stages (see wavefront.h)
+		// instead of one recursive path at a time
+		bool wavefront = false;
+
+		// Wavefront only, sort secondary rays for coherence before tracing them
+		// Only pays off once the BVH no longer fits in cache, the sample scene does
+		bool reorder = false;
+
+		// Path guiding (see path_guide.h), lambertian bounces also head where
+		// earlier passes found light. Null to only sample the materials
+		PathGuide* guide = nullptr;
+
+		// Training pass, paths add what they found to the guide (one path at a time engine only)
+		bool train_guide = false;
+
+		// Denoiser input (see denoiser.h), every pixel's linear color and
+		// first hit albedo and normal go here too. Null to skip them, else
+		// sized to the image before rendering
+		render_buffers* buffers = nullptr;
+
 		/**
 		* Default Constructor
 		*/
@@ -48,14 +83,36 @@ namespace rtw {
 		/**
 		* Render Span (threaded)
 		* 
-		* @param world		Object List
+		* Picks the render_tiles version for this camera and scene once,
+		* see render_tiles
+		* 
+		* Each sample of a tile is one packet of camera rays, traced
+		* through the scene together (see Scene::hit_packet). Bounces
+		* off the first hit go back to one ray at a time.
+		* 
+		* @param world		Scene (objects and materials)
+		* @param s_start	Span start index
+		* @param s_end		Span ending index
+		* @param output		Pixel data output
+		* @param tiles		Randomized tile list, at most ray_packet::MAX_RAYS pixels each
+		* @param n_pixels	Number of completed pixels
+		*/
+		void render_span(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels);
+
+		/**
+		* Render Span Wavefront (threaded)
+		* 
+		* Same as render_span, but every sample of as many tiles as fit
+		* in a batch becomes a path in a Wavefront, traced all together
+		* 
+		* @param world		Scene (objects and materials)
 		* @param s_start	Span start index
 		* @param s_end		Span ending index
 		* @param output		Pixel data output
-		* @param pixels		Randomized span pixel list
+		* @param tiles		Randomized tile list
 		* @param n_pixels	Number of completed pixels
 		*/
-		void render_span(HittableList& world, int s_start, int s_end, unsigned char* output, std::vector<coord>& pixels, int& n_pixels);
+		void render_span_wavefront(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels);
 	
 		/**
 		* Initialize
@@ -65,12 +122,155 @@ namespace rtw {
 		*/
 		void init();
 
+		/**
+		* Sky Color
+		* Color of ray r when it hits nothing: the scene's environment map
+		* if it has one, otherwise a gradient. When the bounce before
+		* sampled the lights too, the environment is weighted against
+		* direct_light having found it (power heuristic). Shared with the
+		* wavefront engine
+		* 
+		* @param world		Scene, with its environment
+		* @param r			Ray
+		* @param bsdf_pdf	Density the last bounce scattered r with, 0 if it didn't sample lights
+		* @param footprint	Angle (radians) r covers, for a blurrier mip level, 0 for a sharp lookup
+		*/
+		static color sky_color(const Scene& world, const ray& r, real bsdf_pdf, real footprint = 0);
+
+		/**
+		* Russian Roulette
+		* Randomly ends a path, survival chance is its brightest throughput
+		* channel. Survivors get divided by that chance, so the image is still
+		* unbiased, just noisier where paths were dark anyway. Shared with the
+		* wavefront engine
+		* 
+		* @param throughput	Path throughput, reweighted if the path survives
+		* @param u			Uniform sample in [0, 1)
+		* 
+		* @return Whether the path survives
+		*/
+		static bool russian_roulette(color& throughput, real u);
+
+		/**
+		* Direct Light
+		* Next event estimation: picks a point on a light (see
+		* Scene::sample_light), and if nothing's in the way, returns the
+		* light it sends back along r through rec's material. Weighted
+		* against scatter finding the same light (power heuristic, see
+		* emitted_light), so glossy surfaces reflecting small lights
+		* get the best of both. Always takes 3 sample dimensions. Shared
+		* with the wavefront engine
+		* 
+		* @param world		Scene, with its lights
+		* @param r			Ray that hit rec
+		* @param rec		Hit Record
+		* @param sampler	Sampler
+		* @param guide		Guide the bounce at rec scatters with, if it's guided (see guided_scatter)
+		* @param last		Path's last bounce, nothing scattered from rec gets traced to
+		*					find the light, so the light sample keeps all of the weight
+		* @param reached	The light sample (ref) if its light reaches rec, pdf 0 if
+		*					not, null when the caller doesn't need it
+		* 
+		* @return Light reflected along -r straight from the sampled light
+		*/
+		static color direct_light(const Scene& world, const ray& r, const hit_record& rec, Sampler& sampler,
+			const PathGuide* guide = nullptr, bool last = false, light_sample* reached = nullptr);
+
+		/**
+		* Emitted Light
+		* What rec's material emits back along r. When the bounce before
+		* sampled the lights too, a light hit here is weighted against
+		* direct_light having found it (power heuristic). Shared with the
+		* wavefront engine
+		* 
+		* @param world		Scene, with its lights
+		* @param r			Ray that hit rec
+		* @param rec		Hit Record
+		* @param mat		rec's material
+		* @param bsdf_pdf	Density the last bounce scattered r with, 0 if it didn't sample lights
+		* 
+		* @return Weighted emission
+		*/
+		static color emitted_light(const Scene& world, const ray& r, const hit_record& rec, const material& mat, real bsdf_pdf);
+
+		/**
+		* Samples Lights
+		* 
+		* @param world	Scene
+		* @param mat	Material at the hit
+		* 
+		* @return Whether to sample the lights directly at a hit on mat
+		*/
+		static bool samples_lights(const Scene& world, const material& mat);
+
+		/**
+		* Guided Scatter
+		* Scatter for a bounce the guide helps with: picks the guide or the
+		* material (one sample MIS, see PathGuide::GUIDE_FRACTION), and
+		* weights by the density of both together. Regions the guide hasn't
+		* learned yet are left to the material. Always takes 3 sample
+		* dimensions. Shared with the wavefront engine
+		* 
+		* @param guide			Path Guide
+		* @param r				Ray that hit rec
+		* @param rec			Hit Record
+		* @param mat			rec's material, non specular
+		* @param attenuation	Color (ref)
+		* @param scattered		Ray Output (ref)
+		* @param pdf			Density scattered was picked with (ref)
+		* @param sampler		Sampler
+		* 
+		* @return Whether the path goes on
+		*/
+		static bool guided_scatter(const PathGuide& guide, const ray& r, const hit_record& rec, const material& mat,
+			color& attenuation, ray& scattered, real& pdf, Sampler& sampler);
+
+		/**
+		* Bounce Guide
+		* 
+		* @param world	Scene
+		* @param guide	Path Guide, null when not guiding
+		* @param rec	Hit Record
+		* 
+		* @return guide if the bounce at rec is guided, null otherwise
+		*/
+		static const PathGuide* bounce_guide(const Scene& world, const PathGuide* guide, const hit_record& rec);
+
+		/**
+		* First Hit Features
+		* What a camera ray adds to the denoiser's feature buffers: the
+		* albedo and normal of what it hit, or the sky (clamped) and no
+		* normal if it missed. Shared with the wavefront engine
+		* 
+		* @param world	Scene
+		* @param r		Camera ray
+		* @param rec	Hit Record of ray r, null if it missed
+		* @param albedo	Albedo (ref)
+		* @param normal	Normal (ref)
+		*/
+		static void first_hit_features(const Scene& world, const ray& r, const hit_record* rec, color& albedo, vec3& normal);
+
+		/**
+		* Write Color
+		* Gamma corrects and clamps a linear color into 8 bit output
+		* 
+		* @param output	Pixel data output
+		* @param width	Image width
+		* @param x
+		* @param y
+		* @param c		Linear color
+		*/
+		static void write_color(unsigned char* output, int width, int x, int y, color c);
+
 	private:
 		// Image dimensions
 		int image_height, image_width;
 
 		// Weighting of samples
 		double sample_scale;
+
+		// Angle one pixel covers, camera rays that miss look up the environment this blurry
+		real pixel_angle;
 		
 		point3 center;         // Camera center
 		point3 pixel00_loc;    // Location of pixel (0, 0)
@@ -82,38 +282,147 @@ namespace rtw {
 		vec3 defocus_disk_u;
 		vec3 defocus_disk_v;
 		
+		// Shadow rays stop this fraction short of the light, so they can't hit the light itself
+		static constexpr real SHADOW_EPSILON = real(1e-4);
+
+		/**
+		* Guide Vertex
+		* A guided bounce, kept while training so what the rest of the path
+		* finds can be added to the guide once it ends
+		*/
+		struct guide_vertex {
+			std::uint32_t region;
+			vec3 direction;		// Direction scattered toward
+			color throughput;	// Throughput once scattered
+			color radiance;		// Radiance gathered before scattering
+			real pdf;			// Density direction was picked with
+		};
+
+		// Most guided bounces of a path kept for training, later ones aren't recorded
+		static const int MAX_GUIDE_VERTICES = 16;
+
+		// Sample dimensions get_ray always uses up (pixel 2, lens 2, time 1),
+		// whether or not those features are on, shading starts after them
+		static const int CAMERA_DIMENSIONS = 5;
+
+		// Signature of render_span and friends
+		using span_fn = void (Camera::*)(const Scene&, int, int, unsigned char*, std::vector<tile>&, int&);
+
+		/**
+		* Render Tiles
+		* render_span's loop, compiled once per combination of features.
+		* Turned off features (no depth of field, nothing in the scene
+		* moving) aren't branched around, they just aren't in the loop
+		* 
+		* @tparam DEFOCUS	Depth of field, rays start on the defocus disk
+		* @tparam MOTION	Motion blur, every ray gets a random time (0 otherwise)
+		*/
+		template <bool DEFOCUS, bool MOTION>
+		void render_tiles(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels);
+
+		/**
+		* Render Tiles Wavefront
+		* render_span_wavefront's loop, see render_tiles
+		*/
+		template <bool DEFOCUS, bool MOTION>
+		void render_tiles_wavefront(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels);
+
 		/**
 		* Ray Color
-		* Finds color of ray r
+		* Finds color of ray r, one bounce after another (no recursion)
 		* 
 		* @param r		Ray
 		* @param depth	Depth of ray r
-		* @param world	Hittable to check against
+		* @param world	Scene to check against
+		* @param sampler	Sampler, already started on this sample
 		*/
-		color ray_color(const ray& r, int depth, const Hittable& world) const;
+		color ray_color(const ray& r, int depth, const Scene& world, Sampler& sampler) const;
+
+		/**
+		* Hit Color
+		* Color of ray r, given what it hit. The path loop lives here,
+		* carrying the throughput from bounce to bounce. Anything that
+		* isn't specular samples the lights directly (direct_light), and
+		* the bounce after it weights the lights it finds to match
+		* (multiple importance sampling). With a guide, lambertian
+		* bounces go through guided_scatter, and training passes train
+		* it with every path once it ends
+		* 
+		* @param r		Ray
+		* @param rec	Hit Record of ray r
+		* @param depth	Depth of ray r
+		* @param world	Scene to check against
+		* @param sampler	Sampler, already started on this sample
+		*/
+		color hit_color(const ray& r, const hit_record& rec, int depth, const Scene& world, Sampler& sampler) const;
+
+		/**
+		* Train Guide
+		* Adds the light each guided bounce of a finished path went on to
+		* find to the guide (what the lights sent straight to each one is
+		* added as it's sampled, see hit_color)
+		* 
+		* @param vertices	Guided bounces
+		* @param n			Number of guided bounces
+		* @param radiance	Everything the path gathered
+		*/
+		void train(const guide_vertex* vertices, int n, const color& radiance) const;
 
 		/**
 		* Get Ray
 		* Creates a ray given (x, y) pixel coords and calculated offsets
 		* 
+		* @tparam DEFOCUS	Start on the defocus disk instead of the center
+		* @tparam MOTION	Random time instead of 0
+		* 
 		* @param x
 		* @param y
+		* @param sample		Sample index within the pixel
+		* @param sampler	Sampler, started on this sample here
 		*/
-		ray get_ray(int x, int y) const;
+		template <bool DEFOCUS, bool MOTION>
+		ray get_ray(int x, int y, int sample, Sampler& sampler) const;
 
 		/**
 		* Sample Square
 		* 
+		* @param u	2D sample
+		* 
 		* @return a random vec3 in the sample square
 		*/
-		vec3 sample_square() const;
+		vec3 sample_square(const vec3& u) const;
 
 		/**
 		* Defocus Disk Sample
 		* 
+		* @param u	2D sample
+		* 
 		* @return Random point on defocus disk
 		*/
-		point3 defocus_disk_sample() const;
+		point3 defocus_disk_sample(const vec3& u) const;
+
+		/**
+		* Write Pixel
+		* Scales a pixel's summed samples, and writes them into output
+		* (see write_color) and the color buffer, if there is one
+		* 
+		* @param output			Pixel data output
+		* @param x
+		* @param y
+		* @param pixel_color	Sum of the pixel's samples
+		*/
+		void write_pixel(unsigned char* output, int x, int y, color pixel_color);
+
+		/**
+		* Write Features
+		* Scales a pixel's summed features into the feature buffers
+		* 
+		* @param x
+		* @param y
+		* @param albedo	Sum of the pixel's first hit albedos
+		* @param normal	Sum of the pixel's first hit normals
+		*/
+		void write_features(int x, int y, color albedo, vec3 normal);
 
 		/**
 		* Linear to Gamma
@@ -121,7 +430,7 @@ namespace rtw {
 		* 
 		* @param linear_component
 		*/
-		double linear_to_gamma(double linear_component);
+		static double linear_to_gamma(double linear_component);
 
 	};
 }
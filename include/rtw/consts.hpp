@@ -13,6 +13,15 @@
 
 namespace rtw {
 
+	// Render path scalar
+	// Build with RTW_SINGLE_PRECISION for a float core (previews, most frames),
+	// otherwise everything on the render path stays double
+#ifdef RTW_SINGLE_PRECISION
+	using real = float;
+#else
+	using real = double;
+#endif
+
 	const double INF = std::numeric_limits<double>::infinity();
 	const double PI = 3.1415926535897932385;
 
@@ -25,6 +34,19 @@ namespace rtw {
 		return deg * PI / 180.0;
 	}
 
+	/**
+	* Rounding Error Bound
+	* Bounds the relative error of n chained floating point operations
+	* in T, (n * u) / (1 - n * u) where u is T's unit roundoff
+	* 
+	* @param n	Number of operations
+	*/
+	template <typename T>
+	inline T gamma_bound(int n) {
+		const T u = std::numeric_limits<T>::epsilon() / 2;
+		return (n * u) / (1 - n * u);
+	}
+
 	/**
 	* Random Double
 	* 
@@ -65,6 +87,16 @@ namespace rtw {
 
 		coord(int X, int Y) { x = X; y = Y; }
 	};
+
+	/**
+	* Tile Structure
+	* Block of pixels [x0, x1) x [y0, y1), the unit threads render in
+	*/
+	struct tile {
+		int x0, y0, x1, y1;
+
+		tile(int X0, int Y0, int X1, int Y1) { x0 = X0; y0 = Y0; x1 = X1; y1 = Y1; }
+	};
 }
 
 
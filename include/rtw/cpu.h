@@ -0,0 +1,70 @@
+// cpu.h - Declaration of the host CPU feature detection
+// Ethan Rudy
+
+#ifndef CPU_H
+#define CPU_H
+
+// x86-64 build, the only place the SIMD kernels exist
+// (SSE2 is guaranteed there, so it needs no runtime check)
+#if defined(__x86_64__) || defined(_M_X64)
+#define RTW_X86
+#endif
+
+namespace rtw {
+
+	/**
+	* CPU Features
+	* What the machine we're running on (not the one we were built
+	* for) supports. Every flag also means the OS saves that
+	* register state, so it's actually safe to use.
+	*/
+	struct cpu_features {
+		bool sse2 = false;
+		bool sse41 = false;
+		bool avx = false;
+		bool avx2 = false;
+		bool fma = false;
+		bool avx512f = false;
+	};
+
+	/**
+	* SIMD Level
+	* The code paths hot kernels are built for, widest last
+	*/
+	enum class simd_level {
+		scalar,
+		sse2,		// 128 bit, part of x86-64
+		avx2,		// 256 bit + FMA (Haswell, Zen)
+		avx512		// 512 bit (Skylake-X and up)
+	};
+
+	/**
+	* Host CPU
+	* Detected once, on first call
+	*
+	* @return Features of the CPU we're running on
+	*/
+	const cpu_features& host_cpu();
+
+	/**
+	* SIMD Level
+	* Widest path the host CPU supports, capped by the RTW_SIMD
+	* environment variable (scalar, sse2, avx2, avx512) if it's set,
+	* handy for comparing paths with the same binary
+	*
+	* @return Level the kernels dispatch to
+	*/
+	simd_level host_simd_level();
+
+	/**
+	* SIMD Level Name
+	*
+	* @param level	Level to name
+	*
+	* @return Name of the level, same spelling RTW_SIMD takes
+	*/
+	const char* simd_level_name(simd_level level);
+
+}
+
+#endif // !CPU_H
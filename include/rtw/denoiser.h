@@ -0,0 +1,143 @@
+// denoiser.h - Declaration of the Denoiser class and its feature buffers
+// Ethan Rudy
+
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include "consts.hpp"
+#include "cpu.h"
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Render Buffers
+	* What the camera leaves behind for the denoiser, every pixel's
+	* linear color plus the albedo and normal of what its camera rays
+	* hit first (averaged over its samples). 3 floats a pixel each,
+	* row after row, same layout as the output image
+	*/
+	struct render_buffers {
+		int width = 0, height = 0;
+		std::vector<float> color;
+		std::vector<float> albedo;
+		std::vector<float> normal;
+
+		/**
+		* Resize
+		*
+		* @param w	Width
+		* @param h	Height
+		*/
+		void resize(int w, int h);
+	};
+
+	/**
+	* Denoise Planes
+	* One float array per channel, so a row's pixels can be loaded
+	* several at a time. Color and variance change every iteration,
+	* the features don't
+	*/
+	struct denoise_planes {
+		int width = 0, height = 0;
+		std::vector<float> r, g, b;			// Linear color
+		std::vector<float> var;				// Luminance variance
+		std::vector<float> ar, ag, ab;		// Albedo
+		std::vector<float> nx, ny, nz;		// Normal
+	};
+
+	/**
+	* Denoise Parameters
+	* One iteration's worth
+	*/
+	struct denoise_params {
+		int step;					// Spacing between taps, doubles every iteration
+		float sigma_luminance;		// Luminance edges, in standard deviations of the noise
+		float inv_sigma_normal2;	// 1 / sigma^2, normal edges
+		float inv_sigma_albedo2;	// 1 / sigma^2, albedo edges
+	};
+
+	/**
+	* Denoiser class
+	*
+	* Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010, with
+	* SVGF's variance-guided luminance weight). Each iteration is a 5x5
+	* B3 spline blur whose taps spread out twice as far as the last's,
+	* so 5 iterations cover 125 pixels for 125 taps a pixel. Every tap
+	* is weighted down by how different it is from the center pixel:
+	* in luminance (relative to how noisy the center is), in normal
+	* and in albedo. So noise gets averaged away, but the outlines of
+	* objects, shading creases and color edges, which the noise-free
+	* feature buffers show, stay sharp.
+	*
+	* Noise is estimated from the image itself (luminance variance
+	* around each pixel), then carried through the iterations along
+	* with the color, so later, wider iterations blur less.
+	*
+	* Rows are split between threads, and each row is filtered several
+	* pixels at a time with the widest SIMD path the CPU has (see
+	* denoiser_simd.h), same dispatch as the sphere kernel.
+	*/
+	class Denoiser {
+	public:
+
+		// Filter Options
+		int iterations = 5;
+		float sigma_luminance = 2.0f;
+		float sigma_normal = 0.3f;
+		float sigma_albedo = 0.1f;
+
+		/**
+		* Denoise
+		*
+		* @param buffers	Color and features to filter
+		* @param output		Filtered linear color (ref), same layout as buffers.color
+		* @param n_threads	Threads to split the rows between
+		*/
+		void denoise(const render_buffers& buffers, std::vector<float>& output, int n_threads) const;
+
+	private:
+
+		/**
+		* Split
+		* Runs rows(y0, y1) over every row of the image, n_threads bands at once
+		*/
+		template <typename F>
+		static void split_rows(int height, int n_threads, F rows);
+
+		/**
+		* Estimate Variance
+		* Luminance variance over the 5x5 pixels around each pixel of rows [y0, y1)
+		*
+		* @param planes	Planes, var is written
+		* @param y0		First row
+		* @param y1		One past the last row
+		*/
+		static void estimate_variance(denoise_planes& planes, int y0, int y1);
+	};
+
+	/**
+	* Denoise Rows
+	* One iteration of the filter over rows [y0, y1): color and variance
+	* from 'in' (features too), filtered color and variance into 'out'.
+	* Picks the widest version the host CPU runs, like intersect_spheres
+	*
+	* @param in		Planes to filter
+	* @param out	Planes filtered into, already sized
+	* @param y0		First row
+	* @param y1		One past the last row
+	* @param p		Parameters
+	*/
+	void denoise_rows(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p);
+
+	// Per instruction set versions of denoise_rows, scalar and SSE2 live in
+	// denoiser.cpp, AVX2 in denoiser_avx2.cpp. Only call one the host CPU supports
+	void denoise_rows_scalar(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p);
+#ifdef RTW_X86
+	void denoise_rows_sse2(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p);
+	void denoise_rows_avx2(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p);
+#endif
+
+}
+
+#endif // !DENOISER_H
@@ -0,0 +1,196 @@
+// denoiser_simd.h - Implementation of the a-trous filter rows, shared by every instruction set
+// Ethan Rudy
+
+#ifndef DENOISER_SIMD_H
+#define DENOISER_SIMD_H
+
+// Only for the denoiser*.cpp files, same rules as sphere_kernel_simd.h:
+// include it after the file's '#pragma GCC target', and instantiate it
+// with traits from an unnamed namespace. Everything here is a template
+// on those traits, so no copy can ever be merged across files.
+
+namespace rtw {
+
+	/**
+	* Denoise Taps
+	* B3 spline, 1/16 1/4 3/8 1/4 1/16, the a-trous wavelet's kernel
+	*/
+	static const float DENOISE_TAPS[5] = { 1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16 };
+
+	/**
+	* Denoise Max Exponent
+	* Edge stopping exponents are capped here, a weight of 1e-10 is
+	* as good as 0, and smaller ones squared (for the variance) go
+	* denormal, which slows the whole filter down several times
+	*/
+	static const float DENOISE_MAX_EXPONENT = 32.0f;
+
+	/**
+	* Denoise Pixels (SIMD)
+	* Filters S::WIDTH pixels of row y, starting at column x, all with
+	* every tap inside the image horizontally (rows are clamped). S wraps
+	* the intrinsics for one instruction set, floats only:
+	*	reg, WIDTH, set1, load, store, add, sub, mul, div, sqrt, min, max
+	*
+	* @param in		Planes to filter
+	* @param out	Planes filtered into
+	* @param x		First column
+	* @param rows	Row index of each of the five vertical taps
+	* @param y		Row
+	* @param p		Parameters
+	*/
+	template <typename S>
+	inline void denoise_pixels_simd(const denoise_planes& in, denoise_planes& out, int x, const int rows[5],
+		int y, const denoise_params& p) {
+
+		using reg = typename S::reg;
+
+		const size_t w = size_t(in.width);
+		const size_t center = size_t(y) * w + x;
+
+		const reg lr = S::set1(0.2126f), lg = S::set1(0.7152f), lb = S::set1(0.0722f);
+		const reg zero = S::set1(0), one = S::set1(1), sixteenth = S::set1(1.0f / 16);
+		const reg inv_sigma_n = S::set1(p.inv_sigma_normal2), inv_sigma_a = S::set1(p.inv_sigma_albedo2);
+		const reg max_e = S::set1(DENOISE_MAX_EXPONENT);
+
+		// Center pixel
+		const reg cr = S::load(&in.r[center]), cg = S::load(&in.g[center]), cb = S::load(&in.b[center]);
+		const reg cl = S::add(S::add(S::mul(lr, cr), S::mul(lg, cg)), S::mul(lb, cb));
+		const reg cnx = S::load(&in.nx[center]), cny = S::load(&in.ny[center]), cnz = S::load(&in.nz[center]);
+		const reg car = S::load(&in.ar[center]), cag = S::load(&in.ag[center]), cab = S::load(&in.ab[center]);
+
+		// Luminance differences count in standard deviations of the center's noise
+		const reg inv_sigma_l = S::div(one, S::add(S::mul(S::set1(p.sigma_luminance),
+			S::sqrt(S::max(S::load(&in.var[center]), zero))), S::set1(1e-4f)));
+
+		reg sum_w = zero, sum_r = zero, sum_g = zero, sum_b = zero, sum_var = zero;
+
+		for (int j = 0; j < 5; ++j) {
+			const size_t row = size_t(rows[j]) * w;
+			for (int i = 0; i < 5; ++i) {
+				const size_t q = row + x + (i - 2) * p.step;
+
+				reg r = S::load(&in.r[q]), g = S::load(&in.g[q]), b = S::load(&in.b[q]);
+				reg l = S::add(S::add(S::mul(lr, r), S::mul(lg, g)), S::mul(lb, b));
+
+				reg dl = S::sub(l, cl);
+				dl = S::max(dl, S::sub(zero, dl));
+
+				reg dx = S::sub(S::load(&in.nx[q]), cnx), dy = S::sub(S::load(&in.ny[q]), cny), dz = S::sub(S::load(&in.nz[q]), cnz);
+				reg dn = S::add(S::add(S::mul(dx, dx), S::mul(dy, dy)), S::mul(dz, dz));
+
+				reg da0 = S::sub(S::load(&in.ar[q]), car), da1 = S::sub(S::load(&in.ag[q]), cag), da2 = S::sub(S::load(&in.ab[q]), cab);
+				reg da = S::add(S::add(S::mul(da0, da0), S::mul(da1, da1)), S::mul(da2, da2));
+
+				reg e = S::add(S::add(S::mul(dl, inv_sigma_l), S::mul(dn, inv_sigma_n)), S::mul(da, inv_sigma_a));
+				e = S::min(e, max_e);
+
+				// exp(-e) as 1 / (1 + e/16)^16, close enough for a weight and no exp
+				reg t = S::add(one, S::mul(e, sixteenth));
+				t = S::mul(t, t); t = S::mul(t, t); t = S::mul(t, t); t = S::mul(t, t);
+				reg weight = S::div(S::set1(DENOISE_TAPS[i] * DENOISE_TAPS[j]), t);
+
+				sum_w = S::add(sum_w, weight);
+				sum_r = S::add(sum_r, S::mul(weight, r));
+				sum_g = S::add(sum_g, S::mul(weight, g));
+				sum_b = S::add(sum_b, S::mul(weight, b));
+				sum_var = S::add(sum_var, S::mul(S::mul(weight, weight), S::load(&in.var[q])));
+			}
+		}
+
+		// The center tap's weight is never 0, so neither is sum_w
+		reg inv_w = S::div(one, sum_w);
+		S::store(&out.r[center], S::mul(sum_r, inv_w));
+		S::store(&out.g[center], S::mul(sum_g, inv_w));
+		S::store(&out.b[center], S::mul(sum_b, inv_w));
+		S::store(&out.var[center], S::mul(sum_var, S::mul(inv_w, inv_w)));
+	}
+
+	/**
+	* Denoise Pixel
+	* One pixel, any column, taps past the left or right edge are clamped.
+	* Same math as denoise_pixels_simd
+	*
+	* @param in		Planes to filter
+	* @param out	Planes filtered into
+	* @param x		Column
+	* @param rows	Row index of each of the five vertical taps
+	* @param y		Row
+	* @param p		Parameters
+	*/
+	template <typename S>
+	inline void denoise_pixel(const denoise_planes& in, denoise_planes& out, int x, const int rows[5],
+		int y, const denoise_params& p) {
+
+		const size_t w = size_t(in.width);
+		const size_t center = size_t(y) * w + x;
+
+		const float cl = 0.2126f * in.r[center] + 0.7152f * in.g[center] + 0.0722f * in.b[center];
+		const float inv_sigma_l = 1.0f / (p.sigma_luminance * std::sqrt(std::max(in.var[center], 0.0f)) + 1e-4f);
+
+		float sum_w = 0, sum_r = 0, sum_g = 0, sum_b = 0, sum_var = 0;
+
+		for (int j = 0; j < 5; ++j) {
+			const size_t row = size_t(rows[j]) * w;
+			for (int i = 0; i < 5; ++i) {
+				const int column = std::max(0, std::min(x + (i - 2) * p.step, in.width - 1));
+				const size_t q = row + column;
+
+				float l = 0.2126f * in.r[q] + 0.7152f * in.g[q] + 0.0722f * in.b[q];
+				float dl = std::fabs(l - cl);
+
+				float dx = in.nx[q] - in.nx[center], dy = in.ny[q] - in.ny[center], dz = in.nz[q] - in.nz[center];
+				float dn = dx * dx + dy * dy + dz * dz;
+
+				float da0 = in.ar[q] - in.ar[center], da1 = in.ag[q] - in.ag[center], da2 = in.ab[q] - in.ab[center];
+				float da = da0 * da0 + da1 * da1 + da2 * da2;
+
+				float e = std::min(dl * inv_sigma_l + dn * p.inv_sigma_normal2 + da * p.inv_sigma_albedo2, DENOISE_MAX_EXPONENT);
+
+				float t = 1 + e / 16;
+				t *= t; t *= t; t *= t; t *= t;
+				float weight = DENOISE_TAPS[i] * DENOISE_TAPS[j] / t;
+
+				sum_w += weight;
+				sum_r += weight * in.r[q];
+				sum_g += weight * in.g[q];
+				sum_b += weight * in.b[q];
+				sum_var += weight * weight * in.var[q];
+			}
+		}
+
+		float inv_w = 1 / sum_w;
+		out.r[center] = sum_r * inv_w;
+		out.g[center] = sum_g * inv_w;
+		out.b[center] = sum_b * inv_w;
+		out.var[center] = sum_var * inv_w * inv_w;
+	}
+
+	/**
+	* Denoise Rows (SIMD)
+	* Same parameters as denoise_rows. Columns close enough to the left
+	* or right edge for a tap to fall off are done one at a time
+	*/
+	template <typename S>
+	inline void denoise_rows_simd(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p) {
+		const int width = in.width;
+		const int reach = 2 * p.step;
+
+		// Columns every tap of S::WIDTH pixels fits around
+		const int inner_begin = std::min(reach, width);
+		const int inner_end = std::max(inner_begin, width - reach);
+
+		for (int y = y0; y < y1; ++y) {
+			int rows[5];
+			for (int j = 0; j < 5; ++j) { rows[j] = std::max(0, std::min(y + (j - 2) * p.step, in.height - 1)); }
+
+			int x = 0;
+			for (; x < inner_begin; ++x) { denoise_pixel<S>(in, out, x, rows, y, p); }
+			for (; x + S::WIDTH <= inner_end; x += S::WIDTH) { denoise_pixels_simd<S>(in, out, x, rows, y, p); }
+			for (; x < width; ++x) { denoise_pixel<S>(in, out, x, rows, y, p); }
+		}
+	}
+
+}
+
+#endif // !DENOISER_SIMD_H
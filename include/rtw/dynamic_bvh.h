@@ -0,0 +1,232 @@
+// dynamic_bvh.h - Declaration of the dynamic_bvh class
+// Ethan Rudy
+
+#ifndef DYNAMIC_BVH_H
+#define DYNAMIC_BVH_H
+
+#include "aabb.h"
+#include "hittable.hpp"
+#include "hittable_list.h"
+#include <algorithm>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Dynamic Bounding Volume Hierarchy
+	*
+	* A BVH that can be edited one object at a time, for scenes that
+	* change while you're looking at them. Objects are inserted next to
+	* the sibling that grows the tree's surface area the least, and every
+	* edit walks back up to the root refitting boxes and rotating nodes
+	* to keep the tree balanced. Nothing ever gets fully rebuilt.
+	*
+	* Leaves store a slightly "fat" box, so small moves that stay inside
+	* it don't touch the tree at all.
+	*
+	* Edits are NOT thread safe with rendering, finish editing before
+	* the span threads start hitting the tree.
+	*
+	* Subclass of Hittable
+	*/
+	class dynamic_bvh : public Hittable {
+	public:
+
+		// Id of an invalid/missing node
+		static const int NULL_NODE = -1;
+
+		/**
+		* Margin Constructor
+		*
+		* @param margin	How much leaf boxes are fattened by on each axis
+		*/
+		dynamic_bvh(real margin = 0.1);
+
+		/**
+		* List Constructor
+		* Inserts every object from the list
+		*
+		* @param list	HittableList object
+		* @param margin	How much leaf boxes are fattened by on each axis
+		*/
+		dynamic_bvh(const HittableList& list, real margin = 0.1);
+
+		/**
+		* Insert
+		*
+		* @param object	Pointer to a Hittable object
+		*
+		* @return Id of the object's leaf, used for removing/moving it later
+		*/
+		int insert(std::shared_ptr<Hittable> object);
+
+		/**
+		* Remove
+		*
+		* @param id	Leaf id returned by insert
+		*/
+		void remove(int id);
+
+		/**
+		* Move
+		* Call after the object's bounding box changed
+		*
+		* @param id	Leaf id returned by insert
+		*
+		* @return Whether the tree had to be restructured
+		*/
+		bool move(int id);
+
+		/**
+		* Move (replace)
+		* Swaps the leaf's object for a new one, ex a copy at a new position
+		*
+		* @param id		Leaf id returned by insert
+		* @param object	Pointer to the new Hittable object
+		*
+		* @return Whether the tree had to be restructured
+		*/
+		bool move(int id, std::shared_ptr<Hittable> object);
+
+		/**
+		* Number of objects in the tree
+		*/
+		size_t size() const;
+
+		/**
+		* Height of the tree (a single leaf is 0)
+		*/
+		int height() const;
+
+		/**
+		* Hit
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param rec	Hit Record
+		*
+		* @return Whether anything in the tree was hit
+		*/
+		bool hit(const ray& r, Interval ray_t, hit_record& rec) const override;
+
+		/**
+		* Intersect
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param info	Closest hit
+		*
+		* @return Whether anything in the tree was hit
+		*/
+		bool intersect(const ray& r, Interval ray_t, hit_info& info) const override;
+
+		/**
+		* Occluded
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		*
+		* @return Whether anything in the tree was hit, stopping at the first
+		*/
+		bool occluded(const ray& r, Interval ray_t) const override;
+
+		/**
+		* Bounding Box
+		*
+		* @return The bounding box of the whole tree
+		*/
+		aabb bounding_box() const override;
+
+	private:
+
+		/**
+		* Node structure
+		* Leaves hold an object, internal nodes hold two children
+		* Free nodes reuse parent as the next free node
+		*/
+		struct node {
+			aabb box;
+			std::shared_ptr<Hittable> object;
+			int parent = NULL_NODE;
+			int left = NULL_NODE;
+			int right = NULL_NODE;
+			int height = 0;
+
+			bool is_leaf() const { return left == NULL_NODE; }
+		};
+
+		std::vector<node> nodes;
+		int root;
+		int free_list;
+		size_t n_objects;
+		real margin;
+
+		/**
+		* Allocate Node
+		*
+		* @return Id of a fresh node, reused from the free list if possible
+		*/
+		int allocate_node();
+
+		/**
+		* Free Node
+		*
+		* @param id	Node to put back on the free list
+		*/
+		void free_node(int id);
+
+		/**
+		* Fat Box
+		*
+		* @param object	Object to box
+		*
+		* @return The object's box expanded by the margin
+		*/
+		aabb fat_box(const Hittable& object) const;
+
+		/**
+		* Insert Leaf
+		* Finds the cheapest sibling and links the leaf in next to it
+		*
+		* @param leaf	Leaf node id
+		*/
+		void insert_leaf(int leaf);
+
+		/**
+		* Remove Leaf
+		* Unlinks the leaf and collapses its parent
+		*
+		* @param leaf	Leaf node id
+		*/
+		void remove_leaf(int leaf);
+
+		/**
+		* Refit Upwards
+		* Rebalances and refits every node from index to the root
+		*
+		* @param index	Node to start at
+		*/
+		void refit_upwards(int index);
+
+		/**
+		* Balance
+		* Rotates a child up if the node is lopsided
+		*
+		* @param a	Node to balance
+		*
+		* @return Id of the node now in a's place
+		*/
+		int balance(int a);
+
+		/**
+		* Refit
+		* Recomputes a node's box and height from its children
+		*
+		* @param index	Node to refit
+		*/
+		void refit(int index);
+	};
+
+}
+
+#endif // !DYNAMIC_BVH_H
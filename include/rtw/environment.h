@@ -0,0 +1,167 @@
+// environment.h - Declaration of the EnvironmentMap class
+// Ethan Rudy
+
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include "consts.hpp"
+#include "vec3.hpp"
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Environment Map class
+	*
+	* HDR image wrapped around the whole scene (latitude-longitude), what
+	* rays that miss everything see instead of the sky gradient. The top
+	* row is straight up (+y), the left column looks down +x and the
+	* columns go around toward +z.
+	*
+	* Texels stay floats whatever real is, and everything needed to
+	* sample the map is worked out once when it's made: one CDF over
+	* the rows (the marginal) and one CDF over each row's texels (the
+	* conditionals), weighted by brightness and by how much solid angle
+	* the row covers. Sampling is two binary searches, so a sun in the
+	* map gets found by next event estimation (see Scene::sample_light)
+	* instead of waiting for a bounce to stumble into it. CDFs rather
+	* than an alias table, they keep neighbouring sample values next to
+	* each other, so the low discrepancy samplers stay stratified.
+	*
+	* Optionally the map is mipped (2x2 box filter down to 1x1), so rays
+	* that cover more than a texel (camera rays, see Camera::init) can
+	* look up a prefiltered level instead of aliasing.
+	*
+	* Read only once made, safe to share between render threads.
+	*/
+	class EnvironmentMap {
+	public:
+
+		/**
+		* Constructor
+		* Loads an HDR (or any stb_image readable) file, the map is left
+		* empty (see valid) if it can't be read
+		*
+		* @param path	Image file
+		* @param mips	Whether to build the mip chain for lookups
+		*/
+		EnvironmentMap(const char* path, bool mips = false);
+
+		/**
+		* Pixel Constructor
+		*
+		* @param width	Width in texels
+		* @param height	Height in texels
+		* @param rgb	width * height RGB texels, top row first
+		* @param mips	Whether to build the mip chain for lookups
+		*/
+		EnvironmentMap(int width, int height, const float* rgb, bool mips = false);
+
+		/**
+		* Valid
+		*
+		* @return Whether the map has any texels
+		*/
+		bool valid() const;
+
+		/**
+		* Lookup
+		* Bilinear, or trilinear between the two mip levels closest to
+		* the footprint when the map has them
+		*
+		* @param direction	Unit direction
+		* @param footprint	Angle (radians) the ray covers, 0 for the full resolution map
+		*
+		* @return Radiance coming from direction
+		*/
+		color lookup(const vec3& direction, real footprint = 0) const;
+
+		/**
+		* Sample
+		* Picks a direction, brighter texels more often
+		*
+		* @param u			2D sample
+		* @param direction	Unit direction picked (ref)
+		* @param pdf		Solid angle density of direction (ref), 0 if there's nothing to pick
+		*
+		* @return Radiance coming from direction
+		*/
+		color sample(const vec3& u, vec3& direction, real& pdf) const;
+
+		/**
+		* PDF
+		*
+		* @param direction	Unit direction
+		*
+		* @return Solid angle density sample would pick direction with
+		*/
+		real pdf(const vec3& direction) const;
+
+		/**
+		* Power
+		*
+		* @return Luminance integrated over every direction, 4 pi * average for a uniform map
+		*/
+		real power() const;
+
+	private:
+
+		/**
+		* Mip Level
+		* RGB texels, row after row, top first
+		*/
+		struct mip_level {
+			int width, height;
+			std::vector<float> texels;
+		};
+
+		// Full resolution map first, then each half sized level
+		std::vector<mip_level> levels;
+
+		// Row CDF, then one CDF per row, every one starts at 0 and ends at 1
+		std::vector<float> marginal;		// height + 1
+		std::vector<float> conditional;		// height * (width + 1)
+
+		// Luminance over the sphere
+		real total_power;
+
+		/**
+		* Build
+		* Mips (if asked for) and the sampling CDFs, run once the texels are in
+		*
+		* @param mips	Whether to build the mip chain
+		*/
+		void build(bool mips);
+
+		/**
+		* Build Distribution
+		* Fills in marginal, conditional and total_power
+		*/
+		void build_distribution();
+
+		/**
+		* Texel
+		*
+		* @param level	Mip level
+		* @param x		Column, wraps around
+		* @param y		Row, clamped
+		*
+		* @return The texel's radiance
+		*/
+		color texel(const mip_level& level, int x, int y) const;
+
+		/**
+		* Bilinear
+		*
+		* @param level	Mip level
+		* @param u		Horizontal coordinate, [0, 1) all the way around
+		* @param v		Vertical coordinate, [0, 1] top to bottom
+		*
+		* @return Radiance between the four texels around (u, v)
+		*/
+		color bilinear(const mip_level& level, real u, real v) const;
+	};
+
+}
+
+#endif // !ENVIRONMENT_H
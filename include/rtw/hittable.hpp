@@ -8,14 +8,13 @@
 #include "ray.h"
 #include "interval.h"
 #include "aabb.h"
+#include <cstdint>
 
 namespace rtw {
 
-    // Funky 'declaration?' of the material class (see material.hpp)
-    // Its in the book, and I think it's because hit_record relies on
-    // materials, but hit_record(s) are passed into material functions
-    // circular definition but not really
-    class material;
+    // Index of a material in the scene's MaterialTable (see material_table.h)
+    // Used instead of a shared_ptr so hits never touch a reference count
+    using mat_id = std::uint32_t;
 
     /**
     * Hit Record class
@@ -24,10 +23,12 @@ namespace rtw {
     class hit_record {
     public:
         point3 p;
+        vec3 p_error;   // Bound on p's rounding error per axis, see offset_ray_origin
         vec3 normal;
-        std::shared_ptr<material> mat;
-        double t;
+        mat_id mat;
+        real t;
         bool front_face;
+        std::int32_t light = -1;    // Index in the scene's light list if what was hit is one, else -1
 
         void set_face_normal(const ray& r, const vec3& outward_normal) {
             front_face = dot(r.direction(), outward_normal) < 0;
@@ -36,16 +37,73 @@ namespace rtw {
     };
 
 
+    class Hittable;
+
+    /**
+    * Hit Info
+    * All that's kept while looking for the closest hit, the full
+    * hit_record only gets built once, for the hit that ends up closest
+    * (see Hittable::interaction)
+    */
+    struct hit_info {
+        real t;
+        const Hittable* object;     // Leaf object that was hit
+        std::uint32_t prim;         // Which of its primitives, for objects holding more than one
+    };
+
+
 	// Abstract "hittable" object class
 	class Hittable {
 	public:
 		virtual ~Hittable() = default;
 
         // Returns whether or not a ray makes contact with the Hittable object
+        // rec should only be written to when the object was hit
 		virtual bool hit(const ray& r, Interval ray_t, hit_record& rec) const = 0;
+
+        // Closest hit, only t and what was hit, see interaction for the rest
+        // info should only be written to when the object was hit
+        // Defaults to hit(), so objects that don't split the two still work
+        virtual bool intersect(const ray& r, Interval ray_t, hit_info& info) const {
+            hit_record rec;
+            if (!hit(r, ray_t, rec)) { return false; }
+
+            info.t = rec.t;
+            info.object = this;
+            info.prim = 0;
+            return true;
+        }
+
+        // Whether anything at all is hit inside ray_t (shadow rays, AO)
+        // Stops at the first hit found, which doesn't have to be the closest
+        // Defaults to intersect(), only worth overriding for objects made of other Hittables
+        virtual bool occluded(const ray& r, Interval ray_t) const {
+            hit_info info;
+            return intersect(r, ray_t, info);
+        }
+
+        // Builds the full hit record for a hit found by intersect
+        // Default reruns hit() in a window just around the hit's t
+        virtual void interaction(const ray& r, const hit_info& info, hit_record& rec) const {
+            hit(r, Interval(std::nextafter(info.t, -real(INF)), std::nextafter(info.t, real(INF))), rec);
+        }
 	
         // Returns the bounding box of the Hittable object
         virtual aabb bounding_box() const = 0;
+
+        // Returns the bounding box of the Hittable object at a single ray time
+        // Defaults to the full (swept) box, which is always safe
+        virtual aabb bounding_box_at(real time) const { return bounding_box(); }
+
+    protected:
+        // hit() for anything made of other Hittables: intersect, then one interaction
+        bool deferred_hit(const ray& r, Interval ray_t, hit_record& rec) const {
+            hit_info info;
+            if (!intersect(r, ray_t, info)) { return false; }
+
+            info.object->interaction(r, info, rec);
+            return true;
+        }
     };
 }
 
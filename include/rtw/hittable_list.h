@@ -54,6 +54,20 @@ namespace rtw {
         */
         bool hit(const ray& r, Interval ray_t, hit_record& rec) const override;
 
+        /**
+        * Intersect
+        * 
+        * @returns Whether a ray hits ANY of the contained objects, info is the closest
+        */
+        bool intersect(const ray& r, Interval ray_t, hit_info& info) const override;
+
+        /**
+        * Occluded
+        * 
+        * @returns Whether a ray hits ANY of the contained objects, stopping at the first
+        */
+        bool occluded(const ray& r, Interval ray_t) const override;
+
         /**
         * Bounding box
         * 
@@ -13,17 +13,19 @@ namespace rtw {
 	* Holds a min and max value
 	* Provides functionality of a continuous
 	* set. Stuff like contains, surrounds, etc
+	* Templated on the scalar type, Interval is the 'real' version
 	*/
-	class Interval {
+	template <typename T>
+	class basic_interval {
 	public:
 
 		// Bounds
-		double min, max;
+		T min, max;
 
 		/**
 		* Default Constructor
 		*/
-		Interval();
+		basic_interval();
 
 		/**
 		* Min/Max Constructor
@@ -31,7 +33,7 @@ namespace rtw {
 		* @param min	Minimum value
 		* @param max	Maximum value
 		*/
-		Interval(double min, double max);
+		basic_interval(T min, T max);
 
 		/**
 		* Union Constructor
@@ -40,33 +42,33 @@ namespace rtw {
 		* @param a	Interval One
 		* @param a	Interval Two
 		*/
-		Interval(const Interval& a, const Interval& b);
+		basic_interval(const basic_interval& a, const basic_interval& b);
 
 		/**
 		* Size / Span
 		*/
-		double size() const;
+		T size() const;
 
 		/**
 		* Contains Number 'x'
 		* 
 		* @return whether min <= x <= max
 		*/
-		double contains(double x) const;
+		bool contains(T x) const;
 
 		/**
 		* Surrounds Number 'x'
 		* 
 		* @return whether min < x < max
 		*/
-		bool surrounds(double x) const;
+		bool surrounds(T x) const;
 
 		/**
 		* Clamp 'x'
 		* 
 		* @return A new value of x clamped to the Interval's range
 		*/
-		double clamp(double x) const;
+		T clamp(T x) const;
 
 		/**
 		* Expand
@@ -75,15 +77,15 @@ namespace rtw {
 		* 
 		* @return The expanded Interval
 		*/
-		Interval expand(double delta) const;
+		basic_interval expand(T delta) const;
 
 		// A couple of useful Invervals
-		static const Interval empty;
-		static const Interval universe;
+		static const basic_interval empty;
+		static const basic_interval universe;
 	};
-	
-	
-	
+
+	// Render path Interval
+	using Interval = basic_interval<real>;
 
 }
 
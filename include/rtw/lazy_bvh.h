@@ -0,0 +1,146 @@
+// lazy_bvh.h - Declaration of the lazy_bvh_node class
+// Ethan Rudy
+
+#ifndef LAZY_BVH_H
+#define LAZY_BVH_H
+
+#include "aabb.h"
+#include "bvh.h"
+#include "hittable.hpp"
+#include "hittable_list.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace rtw {
+
+	/**
+	* Lazy Bounding Volume Hierarchy
+	*
+	* For huge scenes where most of the objects never get hit.
+	* Nodes holding more than 'threshold' objects only know their
+	* bounding box at first. The split happens the first time a ray
+	* actually gets inside the box, so off-screen/hidden chunks of
+	* the scene never get built at all.
+	*
+	* Building is thread safe, the first span thread to enter a node
+	* builds it while holding the node's lock, and publishes it with
+	* an atomic flag. Everyone else checks the flag first (without
+	* locking), so once a node is built it costs one atomic load.
+	*
+	* Ranges at or under the threshold are built right away as regular bvh_nodes
+	*
+	* Subclass of Hittable
+	*/
+	class lazy_bvh_node : public Hittable {
+	public:
+
+		/**
+		* List Constructor
+		*
+		* @param list		HittableList object
+		* @param threshold	Largest object count that gets built right away
+		*/
+		lazy_bvh_node(const HittableList& list, size_t threshold = 64);
+
+		/**
+		* Shared Vector Constructor
+		* Only computes the box, the split waits for the first ray
+		*
+		* @param objects	Shared vector of Hittable object pointers
+		* @param start		Start of the selected range
+		* @param end		End of the selected range
+		* @param threshold	Largest object count that gets built right away
+		*/
+		lazy_bvh_node(std::shared_ptr<std::vector<std::shared_ptr<Hittable>>> objects,
+			size_t start, size_t end, size_t threshold);
+
+		/**
+		* Hit
+		* Builds the node first if this is the first ray inside it
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param rec	Hit Record
+		*
+		* @return Whether the node was hit
+		*/
+		bool hit(const ray& r, Interval ray_t, hit_record& rec) const override;
+
+		/**
+		* Intersect
+		* Builds the node first if this is the first ray inside it
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param info	Closest hit
+		*
+		* @return Whether the node was hit
+		*/
+		bool intersect(const ray& r, Interval ray_t, hit_info& info) const override;
+
+		/**
+		* Occluded
+		* Builds the node first if this is the first ray inside it
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		*
+		* @return Whether anything under the node was hit
+		*/
+		bool occluded(const ray& r, Interval ray_t) const override;
+
+		/**
+		* Bounding Box
+		*
+		* @return The bounding box of every object in the node
+		*/
+		aabb bounding_box() const override;
+
+		/**
+		* Is Built
+		*
+		* @return Whether the node has been split yet
+		*/
+		bool is_built() const;
+
+	private:
+
+		// Every object in the tree, each node owns [start, end)
+		std::shared_ptr<std::vector<std::shared_ptr<Hittable>>> objects;
+		size_t start, end;
+		size_t threshold;
+		aabb bbox;
+
+		// Filled in on demand
+		mutable std::shared_ptr<Hittable> left;
+		mutable std::shared_ptr<Hittable> right;
+		mutable std::atomic<bool> built;
+		mutable std::mutex build_mutex;
+
+		/**
+		* Ensure Built
+		* Double checked, only one thread ever builds the node
+		*/
+		void ensure_built() const;
+
+		/**
+		* Build
+		* Splits the range and creates both children
+		*/
+		void build() const;
+
+		/**
+		* Make Child
+		*
+		* @param child_start	Start of the child's range
+		* @param child_end		End of the child's range
+		*
+		* @return Object, bvh_node, or another lazy node depending on size
+		*/
+		std::shared_ptr<Hittable> make_child(size_t child_start, size_t child_end) const;
+	};
+
+}
+
+#endif // !LAZY_BVH_H
@@ -4,12 +4,27 @@
 #ifndef MATERIAL_HPP
 #define MATERIAL_HPP
 
+#include "sampler.h"
 
 namespace rtw {
 
     // Same funky declaration, see hittable.hpp for what I mean
     class hit_record;
 
+    /**
+    * Material Kind
+    * Which built in material something is, so batches of hits can be
+    * grouped by kind and shaded without virtual calls (see wavefront.h)
+    */
+    enum class material_kind : std::uint8_t {
+        lambertian,
+        metal,
+        dielectric,
+        light,
+        other,
+        count
+    };
+
     /**
     * Abstract Material class
     */
@@ -25,12 +40,71 @@ namespace rtw {
         * @param rec            Hit Record (ref)
         * @param attenuation    Color (ref)
         * @param scattered      Ray Output (ref)
+        * @param sampler        Where the random numbers come from (ref)
         */
         virtual bool scatter(
-            const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered
+            const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered, Sampler& sampler
         ) const {
             return false;
         }
+
+        /**
+        * Emitted
+        * Light given off toward r_in's origin, black for anything that isn't a light
+        *
+        * @param r_in           Ray that hit the material (ref)
+        * @param rec            Hit Record (ref)
+        */
+        virtual color emitted(const ray& r_in, const hit_record& rec) const {
+            return color(0, 0, 0);
+        }
+
+        /**
+        * Evaluate
+        * BSDF times the cosine toward direction, what light arriving
+        * from direction gets multiplied by on its way out along -r_in.
+        * Only used when is_specular() is false
+        *
+        * @param r_in           Ray that hit the material (ref)
+        * @param rec            Hit Record (ref)
+        * @param direction      Unit direction toward the light (ref)
+        */
+        virtual color evaluate(const ray& r_in, const hit_record& rec, const vec3& direction) const {
+            return color(0, 0, 0);
+        }
+
+        /**
+        * PDF
+        * Solid angle density scatter picks direction with, so light
+        * sampling and scatter can be weighed against each other (see
+        * Camera::direct_light). Only used when is_specular() is false
+        *
+        * @param r_in           Ray that hit the material (ref)
+        * @param rec            Hit Record (ref)
+        * @param direction      Unit direction (ref)
+        */
+        virtual real pdf(const ray& r_in, const hit_record& rec, const vec3& direction) const {
+            return 0;
+        }
+
+        /**
+        * Is Specular
+        * Whether scatter only ever goes one way for a given r_in (mirrors,
+        * glass) or there's just no evaluate/pdf for it. Lights aren't
+        * sampled for these, scatter finds them
+        */
+        virtual bool is_specular() const {
+            return true;
+        }
+
+        /**
+        * Surface Albedo
+        * Surface color, what the denoiser's albedo buffer gets (see
+        * denoiser.h). White for anything without a color of its own
+        */
+        virtual color surface_albedo() const {
+            return color(1, 1, 1);
+        }
     };
 
     /**
@@ -38,9 +112,9 @@ namespace rtw {
     * Simplest Material. Think perfectly smooth (not shiny) plastics
     * Blender default cube type shit
     * 
-    * Subclass of material
+    * Subclass of material, final so scatter can be called directly
     */
-    class lambertian : public material {
+    class lambertian final : public material {
     public:
         /**
         * Albedo Constructor
@@ -57,32 +131,62 @@ namespace rtw {
         * @param rec            Hit Record (ref)
         * @param attenuation    Color (ref)
         * @param scattered      Ray Output (ref)
+        * @param sampler        Where the random numbers come from (ref)
         */
-        bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered)
+        bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered, Sampler& sampler)
             const override {
             
-            // Simplest bounce
-            auto scatter_direction = rec.normal + random_unit_vector();
-
-            // Catch degenerate scatter direction
-            if (scatter_direction.near_zero()) {
-                scatter_direction = rec.normal;
-            }
+            // Cosine weighted bounce, same distribution as normal + random unit vector
+            // without the degenerate (zero length) case
+            auto scatter_direction = sample_cosine_direction(rec.normal, sampler.get_2d());
 
-            scattered = ray(rec.p, scatter_direction, r_in.time());
+            scattered = ray(offset_ray_origin(rec.p, rec.p_error, rec.normal, scatter_direction), scatter_direction, r_in.time());
             attenuation = albedo;
             return true;
         }
 
+        /**
+        * Evaluate
+        * albedo / pi times the cosine, zero below the surface
+        *
+        * @param r_in           Ray Input (ref)
+        * @param rec            Hit Record (ref)
+        * @param direction      Unit direction toward the light (ref)
+        */
+        color evaluate(const ray& r_in, const hit_record& rec, const vec3& direction) const override {
+            real cosine = std::fmax(real(0), dot(rec.normal, direction));
+            return albedo * real(cosine / PI);
+        }
+
+        /**
+        * PDF
+        * Cosine over pi, see scatter
+        *
+        * @param r_in           Ray Input (ref)
+        * @param rec            Hit Record (ref)
+        * @param direction      Unit direction (ref)
+        */
+        real pdf(const ray& r_in, const hit_record& rec, const vec3& direction) const override {
+            return std::fmax(real(0), dot(rec.normal, direction)) / real(PI);
+        }
+
+        bool is_specular() const override {
+            return false;
+        }
+
+        color surface_albedo() const override {
+            return albedo;
+        }
+
     private:
         color albedo;
     };
 
     /**
     * Metal Material
-    * Subclass of material
+    * Subclass of material, final so scatter can be called directly
     */
-    class metal : public material {
+    class metal final : public material {
     public:
         /**
         * Parameter Constructor
@@ -91,7 +195,7 @@ namespace rtw {
         * @param fuzz       fuzz factor of the metal, ex matte, semi-gloss, full-gloss
         *                   range = [0, 1.0] -> [no fuzz, full fuzz]
         */
-        metal(const color& albedo, double fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
+        metal(const color& albedo, real fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
 
         /**
         * Scatter
@@ -101,32 +205,89 @@ namespace rtw {
         * @param rec            Hit Record (ref)
         * @param attenuation    Color (ref)
         * @param scattered      Ray Output (ref)
+        * @param sampler        Where the random numbers come from (ref)
         */
-        bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered)
+        bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered, Sampler& sampler)
             const override {
             
             // REFLECT
             vec3 reflected = reflect(r_in.direction(), rec.normal);
-            reflected = unit_vector(reflected) + (fuzz * random_unit_vector());
+            reflected = unit_vector(reflected) + (fuzz * sample_unit_vector(sampler.get_2d()));
 
             // Scatter the reflected
-            scattered = ray(rec.p, reflected, r_in.time());
+            scattered = ray(offset_ray_origin(rec.p, rec.p_error, rec.normal, reflected), reflected, r_in.time());
             attenuation = albedo;
             return (dot(scattered.direction(), rec.normal) > 0);
         }
 
+        /**
+        * Evaluate
+        * Scatter's attenuation is always albedo, so BSDF times cosine is
+        * just albedo times how likely scatter is to pick direction
+        *
+        * @param r_in           Ray Input (ref)
+        * @param rec            Hit Record (ref)
+        * @param direction      Unit direction toward the light (ref)
+        */
+        color evaluate(const ray& r_in, const hit_record& rec, const vec3& direction) const override {
+            return albedo * pdf(r_in, rec, direction);
+        }
+
+        /**
+        * PDF
+        * Scatter picks a point on the sphere of radius fuzz around the
+        * mirror direction. A direction passes through that sphere at up
+        * to two points, each adds its area density (1 / sphere area)
+        * turned into solid angle (distance^2 / cosine at the sphere)
+        *
+        * @param r_in           Ray Input (ref)
+        * @param rec            Hit Record (ref)
+        * @param direction      Unit direction (ref)
+        */
+        real pdf(const ray& r_in, const hit_record& rec, const vec3& direction) const override {
+            // Below the surface gets absorbed
+            if (fuzz <= 0 || dot(direction, rec.normal) <= 0) { return 0; }
+
+            vec3 mirror = unit_vector(reflect(r_in.direction(), rec.normal));
+
+            // |t * direction - mirror| = fuzz
+            real b = dot(direction, mirror);
+            real discriminant = b * b - (1 - fuzz * fuzz);
+            if (discriminant < 0) { return 0; }
+
+            real sqrtd = std::sqrt(discriminant);
+            real area_pdf = 1 / (real(4 * PI) * fuzz * fuzz);
+            real roots[2] = { b - sqrtd, b + sqrtd };
+            real density = 0;
+            for (real t : roots) {
+                if (t <= 0) { continue; }
+                real cosine = std::fabs(dot(direction, t * direction - mirror)) / fuzz;
+                if (cosine > 0) { density += area_pdf * t * t / cosine; }
+            }
+
+            return density;
+        }
+
+        bool is_specular() const override {
+            return fuzz <= 0;
+        }
+
+        color surface_albedo() const override {
+            return albedo;
+        }
+
     private:
         color albedo;
-        double fuzz;
+        real fuzz;
     };
 
     /**
     * Dialectric Material
-    * Subclass of material
+    * Subclass of material, final so scatter can be called directly
     * 
     * Glass, Crystals, TRANSPARENT, not translucent
     */
-    class dielectric : public material {
+    class dielectric final : public material {
     public:
         
         /**
@@ -134,7 +295,7 @@ namespace rtw {
         * 
         * @param refraction_index   Index of Refraction. One can find them online for glass, diamond, etc
         */
-        dielectric(double refraction_index) : refraction_index(refraction_index) {}
+        dielectric(real refraction_index) : refraction_index(refraction_index) {}
 
         /**
         * Scatter
@@ -144,8 +305,9 @@ namespace rtw {
         * @param rec            Hit Record (ref)
         * @param attenuation    Color (ref)
         * @param scattered      Ray Output (ref)
+        * @param sampler        Where the random numbers come from (ref)
         */
-        bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered)
+        bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered, Sampler& sampler)
             const override {
 
             // ALWAYS clear/white, idk if I want to add tinting :D
@@ -162,16 +324,18 @@ namespace rtw {
             // We ofc use an approximation bc I don't have all day
 
             // Refract/Reflect calculation
-            double ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
+            real ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
             vec3 unit_direction = unit_vector(r_in.direction());
-            double cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
-            double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
+            real cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
+            real sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
 
             // Cuttof
             bool cannot_refract = ri * sin_theta > 1.0;
             vec3 direction;
 
-            if (cannot_refract || reflectance(cos_theta, ri) > random_double()) {
+            // Always drawn (even when it can't refract), keeps the dimensions lined up
+            real u = sampler.get_1d();
+            if (cannot_refract || reflectance(cos_theta, ri) > u) {
                 // Reflect
                 direction = reflect(unit_direction, rec.normal);
             }
@@ -180,12 +344,12 @@ namespace rtw {
                 direction = refract(unit_direction, rec.normal, ri);
             }
 
-            scattered = ray(rec.p, direction, r_in.time());
+            scattered = ray(offset_ray_origin(rec.p, rec.p_error, rec.normal, direction), direction, r_in.time());
             return true;
         }
 
     private:
-        double refraction_index;
+        real refraction_index;
 
         /**
         * Reflectance
@@ -195,12 +359,52 @@ namespace rtw {
         * 
         * @return How much the material reflects based off ri and angle
         */
-        static double reflectance(double cosine, double refraction_index) {
+        static real reflectance(real cosine, real refraction_index) {
             auto r0 = (1 - refraction_index) / (1 + refraction_index);
             r0 *= r0;
             return r0 + (1 - r0) * std::pow((1 - cosine), 5);
         }
     };
+
+    /**
+    * Diffuse Light Material
+    * Emits the same light in every direction, from its front face only,
+    * and doesn't scatter anything. Spheres made of it are sampled
+    * directly by the camera (see Scene::sample_light)
+    *
+    * Subclass of material, final so scatter can be called directly
+    */
+    class diffuse_light final : public material {
+    public:
+        /**
+        * Emission Constructor
+        *
+        * @param emission   Emitted radiance, can go well past 1
+        */
+        diffuse_light(const color& emission) : emission(emission) {}
+
+        /**
+        * Emitted
+        *
+        * @param r_in           Ray that hit the material (ref)
+        * @param rec            Hit Record (ref)
+        */
+        color emitted(const ray& r_in, const hit_record& rec) const override {
+            return rec.front_face ? emission : color(0, 0, 0);
+        }
+
+        /**
+        * Radiance
+        *
+        * @return What the front face emits
+        */
+        const color& radiance() const {
+            return emission;
+        }
+
+    private:
+        color emission;
+    };
 }
 
 #endif // !MATERIAL_HPP
\ No newline at end of file
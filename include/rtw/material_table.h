@@ -0,0 +1,92 @@
+// material_table.h - Declaration of the MaterialTable class
+// Ethan Rudy
+
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+
+#include "consts.hpp"
+#include "hittable.hpp"
+#include "material.hpp"
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Material Table class
+	*
+	* Scene owned list of every material. Objects and hit records
+	* only store a mat_id (index into this table), so the hot path
+	* never copies a shared_ptr. Copying those means atomic ref count
+	* updates, and with every thread hitting the same couple of
+	* materials, the cores end up fighting over the same cache lines.
+	*/
+	class MaterialTable {
+	public:
+
+		/**
+		* Default Constructor
+		*/
+		MaterialTable();
+
+		/**
+		* Add Material
+		*
+		* @param mat	Pointer to a material
+		*
+		* @return The material's id
+		*/
+		mat_id add(std::shared_ptr<material> mat);
+
+		/**
+		* Add Material (not owned)
+		* For materials something else keeps alive for at least as long,
+		* like the ones Scene::add_material puts in the scene's arena
+		*
+		* @param mat	Pointer to a material
+		*
+		* @return The material's id
+		*/
+		mat_id add(const material* mat);
+
+		/**
+		* Material Lookup
+		*
+		* @param id	Material id
+		*
+		* @return The material, no ref counting involved
+		*/
+		const material& operator[](mat_id id) const;
+
+		/**
+		* Material Kind
+		*
+		* @param id	Material id
+		*
+		* @return Which built in material it is, worked out once when it was added
+		*/
+		material_kind kind(mat_id id) const;
+
+		/**
+		* Size
+		*
+		* @return Number of materials in the table
+		*/
+		size_t size() const;
+
+		/**
+		* Clear
+		* Straightforward, clears the material vector
+		*/
+		void clear();
+
+	private:
+		std::vector<const material*> materials;
+		std::vector<material_kind> kinds;
+
+		// Materials added by shared_ptr, kept alive here
+		std::vector<std::shared_ptr<material>> owned;
+	};
+
+}
+
+#endif // !MATERIAL_TABLE_H
@@ -0,0 +1,114 @@
+// motion_bvh.h - Declaration of the motion_bvh_node class
+// Ethan Rudy
+
+#ifndef MOTION_BVH_H
+#define MOTION_BVH_H
+
+#include "aabb.h"
+#include "hittable.hpp"
+#include "hittable_list.h"
+#include <algorithm>
+
+namespace rtw {
+
+	/**
+	* Motion Blur Bounding Volume Hierarchy
+	*
+	* Same tree as bvh_node, but every node keeps a bounding box
+	* at several evenly spaced time keys across [0, 1]. When a ray
+	* comes through, the box at the ray's time is interpolated from
+	* the two surrounding keys, instead of testing the box swept
+	* over the whole shutter.
+	*
+	* Linear interpolation of the key boxes always contains the
+	* real (linearly moving) contents, so nothing gets culled that
+	* shouldn't be.
+	*
+	* Subclass of Hittable
+	*/
+	class motion_bvh_node : public Hittable {
+	public:
+
+		// Number of time segments (keys = segments + 1)
+		static const int TIME_SEGMENTS = 4;
+
+		/**
+		* List Constructor
+		*
+		* @param list	HittableList object
+		*/
+		motion_bvh_node(HittableList list);
+
+		/**
+		* Vector Constructor
+		*
+		* @param objects	Vector of Hittable object pointers
+		* @param start		Start of the selected range
+		* @param end		End of the selected range
+		*/
+		motion_bvh_node(std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end);
+
+		/**
+		* Hit
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param rec	Hit Record
+		*
+		* @return Whether the node was hit
+		*/
+		bool hit(const ray& r, Interval ray_t, hit_record& rec) const override;
+
+		/**
+		* Intersect
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param info	Closest hit
+		*
+		* @return Whether the node was hit
+		*/
+		bool intersect(const ray& r, Interval ray_t, hit_info& info) const override;
+
+		/**
+		* Occluded
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		*
+		* @return Whether anything under the node was hit
+		*/
+		bool occluded(const ray& r, Interval ray_t) const override;
+
+		/**
+		* Bounding Box
+		*
+		* @return The box over the whole shutter (union of every key)
+		*/
+		aabb bounding_box() const override;
+
+		/**
+		* Bounding Box at Time
+		*
+		* @param time	Ray time
+		*
+		* @return The interpolated box at the given time
+		*/
+		aabb bounding_box_at(real time) const override;
+
+	private:
+
+		std::shared_ptr<Hittable> left;
+		std::shared_ptr<Hittable> right;
+		aabb bbox;
+
+		// Boxes at time = i / TIME_SEGMENTS
+		aabb keys[TIME_SEGMENTS + 1];
+
+		// Comparator (swept box centroid along an axis)
+		static bool box_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b, int axis_index);
+	};
+
+}
+
+#endif // !MOTION_BVH_H
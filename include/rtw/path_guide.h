@@ -0,0 +1,206 @@
+// path_guide.h - Declaration of the PathGuide class
+// Ethan Rudy
+
+#ifndef PATH_GUIDE_H
+#define PATH_GUIDE_H
+
+#include "consts.hpp"
+#include "aabb.h"
+#include "vec3.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Path Guide class
+	*
+	* Learns where light arrives from, all over the scene, so bounces can
+	* head that way on purpose (Muller et al., "Practical Path Guiding").
+	* Space is split by a binary tree (halving the scene's bounding cube,
+	* x, y, z, x, ...), and every leaf of it (a region) keeps a quadtree
+	* over the directions: finer where more light came from, coarser
+	* elsewhere. Directions map to the quadtree's square through an equal
+	* area (cylindrical) mapping, so a quadrant's share of the light is
+	* its share of the density as is.
+	*
+	* Rendering goes in passes. During a training pass every render thread
+	* adds what its paths found to the 'building' quadtrees (record), with
+	* atomic adds, no locks. The sums are fixed point integers, so they
+	* come out the same whatever order the threads add in, and so does
+	* everything learned from them: same seed, same image, with any
+	* number of threads. Between passes (refine), regions that saw
+	* plenty of paths get split, the building quadtrees become the ones
+	* sampled from, and fresh ones are made, subdivided wherever the last
+	* pass found most of the light. Nothing is sampled from a region until
+	* it's been through a pass (trained).
+	*/
+	class PathGuide {
+	public:
+
+		// Chance a guided bounce samples the guide instead of the material
+		static constexpr real GUIDE_FRACTION = real(0.5);
+
+		/**
+		* Default Constructor
+		* Empty, reset before training
+		*/
+		PathGuide();
+
+		/**
+		* Reset
+		* Forgets everything, one region over the whole scene
+		*
+		* @param bounds	Scene bounds
+		*/
+		void reset(const aabb& bounds);
+
+		/**
+		* Region
+		*
+		* @param p	Point
+		*
+		* @return Index of the region p is in
+		*/
+		std::uint32_t region(const point3& p) const;
+
+		/**
+		* Trained
+		*
+		* @param region	Region index
+		*
+		* @return Whether the region has anything to sample from yet
+		*/
+		bool trained(std::uint32_t region) const;
+
+		/**
+		* Sample
+		*
+		* @param region	Trained region index
+		* @param u		2D sample
+		* @param pdf	Solid angle density of the direction (ref)
+		*
+		* @return Unit direction, toward where more light came from
+		*/
+		vec3 sample(std::uint32_t region, const vec3& u, real& pdf) const;
+
+		/**
+		* PDF
+		*
+		* @param region		Region index
+		* @param direction	Unit direction
+		*
+		* @return Solid angle density sample picks direction with, 0 untrained
+		*/
+		real pdf(std::uint32_t region, const vec3& direction) const;
+
+		/**
+		* Record
+		* Thread safe, lock free, and the sums don't depend on the order records come in
+		*
+		* @param region		Region the light arrived in
+		* @param direction	Unit direction the light arrived from
+		* @param radiance	Luminance that arrived, over the density direction was picked with
+		*/
+		void record(std::uint32_t region, const vec3& direction, real radiance);
+
+		/**
+		* Refine
+		* Ends a training pass, not thread safe, run between passes
+		*
+		* @param pass	Number of the pass that just ended, from 0. Passes are
+		*				expected to double their sample count each time
+		*/
+		void refine(int pass);
+
+	private:
+
+		/**
+		* Quadtree Node
+		* Light recorded in each of the four quadrants (fixed point, in
+		* 1 / SUM_SCALE units), and the child node that splits each one
+		* (0 for none, the root is never a child)
+		*/
+		struct quad_node {
+			std::atomic<std::uint64_t> sum[4];
+			std::uint32_t child[4];
+
+			quad_node();
+			quad_node(const quad_node& other);
+			quad_node& operator=(const quad_node& other);
+
+			// Quadrant q's light, back to floating point
+			float value(int q) const;
+		};
+
+		/**
+		* Quadtree
+		* Over [0, 1)^2, root first
+		*/
+		struct quadtree {
+			std::vector<quad_node> nodes;
+
+			quadtree();
+			float total() const;
+		};
+
+		/**
+		* Spatial Node
+		* Splits its box in half along axis (depth % 3), leaves (child[0]
+		* == 0) hold a region instead
+		*/
+		struct spatial_node {
+			std::uint32_t child[2];
+			std::uint32_t region;
+		};
+
+		// Regions split once this many records land in them, scaled up with the pass's samples
+		static const int SPATIAL_THRESHOLD = 12000;
+
+		// Quadrants with more than this fraction of a quadtree's light get split
+		static constexpr float QUAD_THRESHOLD = 0.01f;
+
+		// Fixed point scale of the quadrant sums, and the most a single
+		// record adds (so a pass's worth of fireflies can't overflow them)
+		static constexpr double SUM_SCALE = 65536.0;
+		static constexpr double MAX_RECORD = 1e8;
+
+		// Deepest a quadtree (or the spatial tree) is allowed to get
+		static const int MAX_QUAD_DEPTH = 20;
+		static const int MAX_SPATIAL_DEPTH = 48;
+
+		// Bounding cube, the spatial tree's root box
+		point3 origin;
+		real size;
+
+		// Spatial tree, and per region quadtrees and record counts
+		std::vector<spatial_node> nodes;
+		std::vector<quadtree> sampling;
+		std::vector<quadtree> building;
+		std::vector<std::atomic<std::uint32_t>> records;
+
+		/**
+		* Split Region
+		* Splits spatial node 'node' (a leaf) while it has too many records
+		*
+		* @param node		Spatial node index
+		* @param depth		Its depth
+		* @param count		Records in it
+		* @param threshold	Most records a region can keep
+		*/
+		void split_region(std::uint32_t node, int depth, double count, double threshold);
+
+		/**
+		* Refined
+		*
+		* @param tree	Quadtree with a pass worth of light in it
+		*
+		* @return Empty quadtree, split where tree's light was
+		*/
+		static quadtree refined(const quadtree& tree);
+	};
+
+}
+
+#endif // !PATH_GUIDE_H
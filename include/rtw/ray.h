@@ -10,17 +10,19 @@ namespace rtw {
 
 	/**
 	* Ray Class
-	* Represents a photon using two vectors and a double
+	* Represents a photon using two vectors and a scalar
 	* for time
 	* Start point, direction, and time (along the ray)
+	* Templated on the scalar type, ray is the 'real' version
 	*/
-	class ray {
+	template <typename T>
+	class basic_ray {
 	public:
 
 		/**
 		* Default Constructor
 		*/
-		ray();
+		basic_ray();
 
 		/**
 		* Time Constructor
@@ -29,7 +31,7 @@ namespace rtw {
 		* @param direction	Direction of the ray
 		* @param time		Represents where the photon is along the ray
 		*/
-		ray(const point3& origin, const vec3& direction, double time);
+		basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction, T time);
 
 		/**
 		* Timeless Constructor
@@ -37,26 +39,50 @@ namespace rtw {
 		* @param origin		Start of the ray
 		* @param direction	Direction of the Ray
 		*/
-		ray(const point3& origin, const vec3& direction);
+		basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction);
 
 		// Accessors
-		const point3& origin() const;
-		const point3& direction() const;
-		double time() const;
+		const basic_vec3<T>& origin() const;
+		const basic_vec3<T>& direction() const;
+		T time() const;
 
 		/**
 		* Ray at Time 't'
 		* 
 		* @return Where the simulated ray is at a specified time
 		*/
-		point3 at(double t) const;
+		basic_vec3<T> at(T t) const;
 
 	private:
-		point3 orig;
-		vec3 dir;
-		double tm;
+		basic_vec3<T> orig;
+		basic_vec3<T> dir;
+		T tm;
 	};
 
+	// Render path ray
+	using ray = basic_ray<real>;
+
+	/**
+	* Offset Ray Origin
+	* Pushes a surface point just past its own rounding error, along the
+	* normal, so a ray leaving it can't hit the same surface again and
+	* no fixed t epsilon is needed
+	* (Pharr, Jakob & Humphreys, PBR 3rd ed. 3.9.5)
+	*
+	* Works the same for float and double, the error bound is what
+	* scales with precision.
+	*
+	* @param p			Point on the surface
+	* @param p_error	Bound on the absolute error of each of p's components
+	* @param n			Geometric normal at p (either side)
+	* @param dir		Direction of the new ray, picks the side to offset to
+	*
+	* @return Origin for the new ray
+	*/
+	template <typename T>
+	basic_vec3<T> offset_ray_origin(const basic_vec3<T>& p, const basic_vec3<T>& p_error,
+		const basic_vec3<T>& n, const basic_vec3<T>& dir);
+
 }
 
-#endif // !RAY_H
\ No newline at end of file
+#endif // !RAY_H
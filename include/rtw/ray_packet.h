@@ -0,0 +1,124 @@
+// ray_packet.h - Declaration of the ray_packet struct
+// Ethan Rudy
+
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include "consts.hpp"
+#include "ray.h"
+#include "interval.h"
+#include "aabb.h"
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace rtw {
+
+	/**
+	* Ray Packet
+	*
+	* Up to 64 coherent rays (one 8x8 tile of camera rays) traced
+	* through the BVH together. Membership is a 64 bit mask, bit i
+	* being rays[i].
+	*
+	* Besides the rays themselves the packet keeps interval bounds
+	* over all of them (origins, inverse directions, times), which
+	* let a whole packet be culled against a box with one test
+	* (interval arithmetic, Boulos et al. 2006) before any of the
+	* rays are looked at individually.
+	*/
+	struct ray_packet {
+		// Most rays in one packet, one bit each in a mask
+		static const int MAX_RAYS = 64;
+
+		int size = 0;
+		ray rays[MAX_RAYS];
+
+		// Per ray inverse direction, for the slab tests
+		vec3 inv_dir[MAX_RAYS];
+
+		// Bounds over every ray in the packet, filled in by finalize()
+		Interval origin[3];
+		Interval inv_dir_bounds[3];
+		bool same_sign[3];			// Every direction has the same (non zero) sign on this axis
+		Interval time;
+
+		/**
+		* Clear
+		*/
+		void clear();
+
+		/**
+		* Add
+		*
+		* @param r	Ray, ignored once the packet is full
+		*/
+		void add(const ray& r);
+
+		/**
+		* Finalize
+		* Computes the packet bounds, run after the last add
+		*/
+		void finalize();
+
+		/**
+		* All
+		*
+		* @return Mask with a bit set for every ray in the packet
+		*/
+		std::uint64_t all() const;
+
+		/**
+		* May Hit
+		* Conservative whole packet test, false only when no ray in
+		* the packet can hit the box inside ray_t
+		*
+		* @param box	Box, covering the packet's whole time range
+		* @param ray_t	Interval every ray is limited to
+		*/
+		bool may_hit(const aabb& box, Interval ray_t) const;
+	};
+
+	/**
+	* Lowest Bit
+	*
+	* @param mask	Non zero mask
+	*
+	* @return Index of the lowest set bit
+	*/
+	inline int lowest_bit(std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(mask);
+#elif defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return int(index);
+#else
+		int index = 0;
+		while (!(mask & 1)) { mask >>= 1; ++index; }
+		return index;
+#endif
+	}
+
+	/**
+	* Bit Count
+	*
+	* @param mask	Mask
+	*
+	* @return Number of set bits
+	*/
+	inline int bit_count(std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_popcountll(mask);
+#else
+		int count = 0;
+		for (; mask; mask &= mask - 1) { ++count; }
+		return count;
+#endif
+	}
+
+}
+
+#endif // !RAY_PACKET_H
@@ -11,6 +11,7 @@
 #include <thread>
 #include <vector>
 #include <iomanip>
+#include <chrono>
 
 // Ray Tracing Header(s)
 #include "../../include/rtw/consts.hpp"
@@ -19,7 +20,13 @@
 #include "../../include/rtw/hittable_list.h"
 #include "../../include/rtw/sphere.hpp"
 #include "../../include/rtw/material.hpp"
+#include "../../include/rtw/material_table.h"
 #include "../../include/rtw/bvh.h"
+#include "../../include/rtw/motion_bvh.h"
+#include "../../include/rtw/scene.h"
+#include "../../include/rtw/environment.h"
+#include "../../include/rtw/path_guide.h"
+#include "../../include/rtw/denoiser.h"
 
 
 // "Ray Tracing in One Weekend" namespace
@@ -43,6 +50,8 @@ namespace rtw {
 
 		/**
 		* Render
+		* With guiding on, trains the path guide over a few passes first,
+		* with denoising on, filters the final pass once it's done
 		*/
 		void render();
 
@@ -56,6 +65,16 @@ namespace rtw {
 		*/
 		void get_progress() const;
 
+		/**
+		* Benchmark
+		* Times closest hit (hit) against any hit (occluded) queries on the
+		* world, single threaded, over the same random shadow-ray-like
+		* segments, and prints both
+		* 
+		* @param n_rays	Number of rays
+		*/
+		void benchmark(int n_rays = 1000000) const;
+
 		/**
 		* Done
 		* 
@@ -71,14 +90,35 @@ namespace rtw {
 		// Number of subspan threads
 		int N_THREADS;
 
-		// Pixel spans and progress
-		std::vector<coord> pixels;
+		// Tile size in pixels, a full tile is one ray packet
+		static const int TILE_SIZE = 8;
+
+		// Tile spans and progress
+		std::vector<tile> tiles;
 		int so_far, total_pixels;
 		bool _done;
 
-		// Camera and master object list
+		// Camera and master scene (objects + materials)
 		Camera camera;
-		HittableList world;
+		Scene world;
+
+		// Path guiding, and how many training passes it gets
+		bool guiding;
+		int guide_passes;
+		PathGuide guide;
+
+		// Denoising, and the color and feature buffers the final pass fills in for it
+		bool denoising;
+		Denoiser denoiser;
+		render_buffers buffers;
+
+		/**
+		* Render Pass
+		* One pass over every tile, split between the span threads
+		* 
+		* @param pass_camera	Camera (and its settings) to render the pass with
+		*/
+		void render_pass(const Camera& pass_camera);
 	};
 }
 
@@ -0,0 +1,203 @@
+// sampler.h - Declaration of the Sampler classes
+// Ethan Rudy
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "consts.hpp"
+#include "vec3.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace rtw {
+
+	/**
+	* Sampler Type
+	* Which Sampler the camera hands out to each render thread
+	*/
+	enum class sampler_type {
+		independent,	// Plain uniform random numbers
+		sobol,			// Owen scrambled Sobol
+		blue_noise		// Rank-1 lattice, shifted per pixel by a blue noise tile
+	};
+
+	/**
+	* Abstract Sampler class
+	*
+	* Where every random number used to render a sample comes from.
+	* Samples are addressed by pixel, sample index and dimension: the
+	* camera starts each sample at dimension 0, then every get_1d/get_2d
+	* takes the next dimension(s). Everything that draws numbers (camera,
+	* materials, Russian roulette) has to draw the same count every time
+	* it runs, so dimension d always means the same thing within a pixel,
+	* which is what lets the low discrepancy samplers stratify it.
+	*
+	* Every number is a function of (seed, pixel, sample index, dimension)
+	* alone, never of what was drawn before, so an image comes out bit for
+	* bit the same whatever the thread count, tile order or engine, and
+	* any tile can be re-rendered on its own.
+	*
+	* Not thread safe, every render thread makes its own (make_sampler).
+	*/
+	class Sampler {
+	public:
+		virtual ~Sampler() = default;
+
+		/**
+		* Start Pixel Sample
+		*
+		* @param x			Pixel x
+		* @param y			Pixel y
+		* @param index		Sample index within the pixel
+		* @param dimension	Dimension to continue from, 0 for a fresh sample
+		*/
+		virtual void start_pixel_sample(int x, int y, int index, int dimension = 0) = 0;
+
+		/**
+		* Get 1D
+		*
+		* @return Next sample dimension, in [0, 1)
+		*/
+		virtual real get_1d() = 0;
+
+		/**
+		* Get 2D
+		* Takes two dimensions
+		*
+		* @return Next two sample dimensions as x and y, in [0, 1), z is 0
+		*/
+		virtual vec3 get_2d() = 0;
+
+		/**
+		* Dimension
+		*
+		* @return Next dimension get_1d/get_2d will hand out
+		*/
+		int dimension() const { return dim; }
+
+	protected:
+		int dim = 0;
+	};
+
+	/**
+	* Independent Sampler
+	* Every dimension an independent uniform random number, plain Monte Carlo.
+	* Counter based, each number is a hash of its seed, pixel, sample index
+	* and dimension
+	*/
+	class IndependentSampler final : public Sampler {
+	public:
+
+		/**
+		* Seed Constructor
+		*
+		* @param seed	Seed
+		*/
+		IndependentSampler(std::uint32_t seed);
+
+		void start_pixel_sample(int x, int y, int index, int dimension = 0) override;
+		real get_1d() override;
+		vec3 get_2d() override;
+
+	private:
+		std::uint32_t seed;
+		std::uint32_t sample_seed;	// Hash of seed, pixel and sample index
+	};
+
+	/**
+	* Sobol Sampler
+	*
+	* Owen scrambled Sobol points, hash based (Burley 2020, "Practical
+	* Hash-based Owen Scrambling"). Every dimension (or pair of
+	* dimensions for get_2d) uses the first one (or two) Sobol dimensions,
+	* with the sample index shuffled and the result Owen scrambled by
+	* seeds hashed from pixel and dimension. So each pixel gets its own
+	* stratified point set in every dimension, with no correlation between
+	* pixels or dimensions, and no table of direction numbers.
+	*
+	* Samples per pixel don't have to be a power of 2, but the points are
+	* best stratified when they are.
+	*/
+	class SobolSampler final : public Sampler {
+	public:
+
+		/**
+		* Seed Constructor
+		*
+		* @param seed	Scramble seed
+		*/
+		SobolSampler(std::uint32_t seed);
+
+		void start_pixel_sample(int x, int y, int index, int dimension = 0) override;
+		real get_1d() override;
+		vec3 get_2d() override;
+
+	private:
+		std::uint32_t seed;
+		std::uint32_t pixel_seed;
+		std::uint32_t sample_index;
+	};
+
+	/**
+	* Blue Noise Sampler
+	*
+	* Every pixel gets the same rank-1 lattice of sample points, only
+	* toroidally shifted (Cranley-Patterson rotation) by that pixel's
+	* value in a tiled blue noise texture. Neighbouring pixels then get
+	* very different shifts, so their errors cancel out to high
+	* frequency noise instead of clumping, which is what makes low
+	* sample previews readable. Each dimension looks the texture up at
+	* its own offset and permutes the sample index its own way, so
+	* dimensions don't correlate.
+	*
+	* The texture is made once (void and cluster, Ulichney 1993) on
+	* first use. Needs the sample count up front to build the lattice.
+	*/
+	class BlueNoiseSampler final : public Sampler {
+	public:
+		// Blue noise texture is TILE_SIZE x TILE_SIZE, power of 2
+		static const int TILE_SIZE = 64;
+
+		/**
+		* Seed Constructor
+		*
+		* @param seed		Seed for the permutations and texture offsets
+		* @param samples	Samples per pixel
+		*/
+		BlueNoiseSampler(std::uint32_t seed, int samples);
+
+		void start_pixel_sample(int x, int y, int index, int dimension = 0) override;
+		real get_1d() override;
+		vec3 get_2d() override;
+
+	private:
+		std::uint32_t seed;
+		std::uint32_t samples;
+		std::uint32_t generator;	// Lattice points are (i, i * generator) / samples
+		int pixel_x, pixel_y;
+		std::uint32_t sample_index;
+
+		/**
+		* Shift
+		*
+		* @param key	Hash picking where in the blue noise tile to look
+		*
+		* @return This pixel's shift for the dimension key belongs to
+		*/
+		double shift(std::uint32_t key) const;
+	};
+
+	/**
+	* Make Sampler
+	*
+	* @param type		Sampler type
+	* @param seed		Seed
+	* @param samples	Samples per pixel
+	*
+	* @return New sampler of the given type
+	*/
+	std::unique_ptr<Sampler> make_sampler(sampler_type type, std::uint32_t seed, int samples);
+
+}
+
+#endif // !SAMPLER_H
@@ -0,0 +1,456 @@
+// scene.h - Declaration of the Scene class
+// Ethan Rudy
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "consts.hpp"
+#include "aabb.h"
+#include "arena.h"
+#include "environment.h"
+#include "hittable.hpp"
+#include "material_table.h"
+#include "ray_packet.h"
+#include "sphere_kernel.h"
+#include <cstdint>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Primitive Type
+	* Tag stored with every primitive reference, picks which array it lives in
+	*/
+	enum class prim_type : std::uint32_t {
+		sphere,
+		moving_sphere,
+		object
+	};
+
+	/**
+	* Primitive Reference
+	* Type tag plus the index into that type's array
+	*/
+	struct prim_ref {
+		prim_type type;
+		std::uint32_t index;
+	};
+
+	/**
+	* Sphere Primitive
+	*/
+	struct sphere_prim {
+		point3 center;
+		real radius;
+		mat_id mat;
+	};
+
+	/**
+	* Moving Sphere Primitive
+	* center(time) = center1 + time * center_vec
+	*/
+	struct moving_sphere_prim {
+		point3 center1;
+		vec3 center_vec;
+		real radius;
+		mat_id mat;
+	};
+
+	/**
+	* Light Sample
+	* Direction toward a point picked on a light, see Scene::sample_light
+	*/
+	struct light_sample {
+		vec3 direction;		// Unit direction toward the light
+		point3 point;		// Point picked on the light's surface
+		color emission;		// What the light gives off back along direction
+		real pdf;			// Solid angle density of direction, including picking this light
+		bool infinite;		// The environment, no point, anything along direction shadows it
+	};
+
+	/**
+	* Scene class
+	*
+	* Closed world version of HittableList + bvh_node. The built in
+	* primitives sit in their own contiguous arrays (one per type), and
+	* the acceleration structure is one flat array of nodes. Traversal
+	* is a loop, and primitives get picked by their type tag with a
+	* switch, so nothing built in goes through a virtual call.
+	*
+	* Anything else (user Hittables, other BVHs, etc) can still be added
+	* as an object, those go through the usual virtual hit().
+	*
+	* At build time every sphere (moving or not) gets copied into one
+	* structure of arrays in leaf order, so each leaf's spheres are tested
+	* together by the SIMD sphere kernel (see sphere_kernel.h). Traversal
+	* only carries a hit_info (objects are asked to intersect, not hit),
+	* and the hit record is filled in once at the very end.
+	*
+	* Camera rays can also be traced a whole packet at a time (see
+	* hit_packet), sharing one walk of the tree between them.
+	*
+	* Nodes keep a box at time 0 and time 1 and get interpolated at the
+	* ray's time, same idea as motion_bvh_node but with two keys since
+	* everything built in moves linearly.
+	*
+	* Built in spheres with a diffuse_light material are the scene's
+	* lights, collected at build time so the camera can sample them
+	* directly (sample_light). Objects can still emit, they just only
+	* get found by bouncing into them. An environment map (see
+	* set_environment) is one more light, picked by its power like the
+	* rest, so it gets sampled directly too.
+	*
+	* Materials and objects can be created straight into the scene's
+	* arena (add_material, emplace), so they sit next to each other in
+	* the order they were added, and clear() frees all of them at once.
+	*
+	* Subclass of Hittable (so it can still be nested), marked final
+	* so calls through a Scene& don't need the vtable either.
+	*/
+	class Scene final : public Hittable {
+	public:
+
+		// Every material the primitives index into
+		MaterialTable materials;
+
+		/**
+		* Default Constructor
+		*/
+		Scene();
+
+		/**
+		* Add Sphere
+		*
+		* @param center		Center of the sphere
+		* @param radius		Radius of the sphere
+		* @param mat		Material of the sphere
+		*/
+		void add_sphere(const point3& center, real radius, mat_id mat);
+
+		/**
+		* Add Moving Sphere
+		*
+		* @param center1	Starting center (time 0)
+		* @param center2	Ending center (time 1)
+		* @param radius		Radius of the sphere
+		* @param mat		Material of the sphere
+		*/
+		void add_moving_sphere(const point3& center1, const point3& center2, real radius, mat_id mat);
+
+		/**
+		* Add Object
+		* Extension point for anything that isn't built in
+		*
+		* @param object	Pointer to a Hittable object
+		*/
+		void add(std::shared_ptr<Hittable> object);
+
+		/**
+		* Emplace Object
+		* Same as add, but the object is created in the scene's arena
+		*
+		* @param args	T's constructor arguments
+		*
+		* @return Pointer to the object, valid until clear()
+		*/
+		template <typename T, typename... Args>
+		T* emplace(Args&&... args) {
+			T* object = arena.create<T>(std::forward<Args>(args)...);
+			objects.push_back(object);
+			return object;
+		}
+
+		/**
+		* Add Material
+		* Creates a material in the scene's arena and adds it to the table
+		*
+		* @param args	M's constructor arguments
+		*
+		* @return The material's id
+		*/
+		template <typename M, typename... Args>
+		mat_id add_material(Args&&... args) {
+			return materials.add(arena.create<M>(std::forward<Args>(args)...));
+		}
+
+		/**
+		* Set Environment
+		* What rays that miss everything see, and a light. Set before build(),
+		* null (or an empty map) goes back to the camera's sky gradient
+		*
+		* @param map	Environment map, shared, it's never changed
+		*/
+		void set_environment(std::shared_ptr<const EnvironmentMap> map);
+
+		/**
+		* Environment
+		*
+		* @return The environment map, null if there isn't one
+		*/
+		const EnvironmentMap* environment() const;
+
+		/**
+		* Clear
+		* Removes every primitive, object, material and the environment, and frees the arena
+		*/
+		void clear();
+
+		/**
+		* Build
+		* Builds the flat BVH, run after adding everything and before rendering
+		*/
+		void build();
+
+		/**
+		* Hit
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param rec	Hit Record
+		*
+		* @return Whether anything in the scene was hit
+		*/
+		bool hit(const ray& r, Interval ray_t, hit_record& rec) const override;
+
+		/**
+		* Intersect
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		* @param info	Closest hit, a built in sphere's object is the scene and prim its SoA index
+		*
+		* @return Whether anything in the scene was hit
+		*/
+		bool intersect(const ray& r, Interval ray_t, hit_info& info) const override;
+
+		/**
+		* Interaction
+		*
+		* @param r		Ray
+		* @param info	Hit found by intersect
+		* @param rec	Hit Record
+		*/
+		void interaction(const ray& r, const hit_info& info, hit_record& rec) const override;
+
+		/**
+		* Occluded
+		*
+		* Own traversal loop, separate from hit()'s: no child ordering,
+		* no closest t to shrink, and the first sphere or object hit ends it
+		*
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r
+		*
+		* @return Whether anything in the scene is hit inside ray_t
+		*/
+		bool occluded(const ray& r, Interval ray_t) const override;
+
+		/**
+		* Hit Packet
+		*
+		* Closest hit for every ray of a coherent packet. The packet
+		* walks the tree together, nodes are first culled for the whole
+		* packet with interval arithmetic (ray_packet::may_hit), then
+		* per ray to narrow down which rays are still active below the
+		* node. Once too few rays are left to be worth it, they each
+		* finish that subtree on their own like hit() would.
+		*
+		* @param packet	Finalized ray packet
+		* @param ray_t	Interval (time) of every ray in the packet
+		* @param recs	Hit Records, one per ray in the packet
+		*
+		* @return Mask of the rays that hit something, recs are only filled in for those
+		*/
+		std::uint64_t hit_packet(const ray_packet& packet, Interval ray_t, hit_record* recs) const;
+
+		/**
+		* Sample Light
+		*
+		* Picks a light (brighter, bigger lights more often), then a
+		* direction toward it from p. Directions are spread evenly over
+		* the cone the light's sphere covers as seen from p, so small or
+		* far away lights don't waste samples on the side facing away.
+		* The environment picks its direction from its map instead
+		*
+		* @param p			Point being lit
+		* @param time		Ray time, lights can move
+		* @param u_pick		Uniform sample for picking the light
+		* @param u			2D sample for the direction
+		* @param ls			Light Sample (ref), only written to when there is one
+		*
+		* @return Whether there's a light sample, false if the scene has no lights
+		*/
+		bool sample_light(const point3& p, real time, real u_pick, const vec3& u, light_sample& ls) const;
+
+		/**
+		* Light PDF
+		* Density sample_light would have picked r's direction with,
+		* for a ray that hit a light
+		*
+		* @param r		Ray, from the point being lit
+		* @param rec	Where r hit the light
+		*
+		* @return Solid angle density, including picking the light, 0 if rec isn't a light
+		*/
+		real light_pdf(const ray& r, const hit_record& rec) const;
+
+		/**
+		* Environment PDF
+		* Density sample_light would have picked direction with, for a ray
+		* that missed everything
+		*
+		* @param direction	Unit direction
+		*
+		* @return Solid angle density, including picking the environment, 0 without one
+		*/
+		real environment_pdf(const vec3& direction) const;
+
+		/**
+		* Has Lights
+		*
+		* @return Whether anything can be picked by sample_light
+		*/
+		bool has_lights() const;
+
+		/**
+		* Has Motion
+		*
+		* @return Whether anything might depend on ray time: a moving
+		* sphere that actually moves, or any object (those could do anything)
+		*/
+		bool has_motion() const;
+
+		/**
+		* Bounding Box
+		*
+		* @return The bounding box of the whole scene
+		*/
+		aabb bounding_box() const override;
+
+	private:
+
+		/**
+		* Flat BVH Node
+		* Interior nodes: left child is the next node, right child is 'offset'
+		* Leaf nodes: 'count' spheres in the SoA starting at 'offset',
+		* and 'object_count' object refs starting at 'object_offset'
+		*/
+		struct flat_node {
+			aabb box0;
+			aabb box1;
+			std::uint32_t offset;
+			std::uint32_t object_offset;
+			std::uint16_t count;
+			std::uint8_t object_count;
+			std::uint8_t axis;
+
+			bool is_leaf() const { return count + object_count > 0; }
+		};
+
+		/**
+		* Build Primitive
+		* Per primitive data only needed while building
+		*/
+		struct build_prim {
+			prim_ref ref;
+			aabb box0, box1;
+			point3 centroid;
+		};
+
+		// Most primitives a leaf can hold
+		static const int MAX_LEAF_SIZE = 4;
+
+		// Packets with this few active rays left split into single rays
+		static const int SINGLE_RAY_THRESHOLD = 4;
+
+		// Deepest the build splits with the SAH, deeper ranges are split at
+		// the median. The SAH alone can peel off one primitive per level
+		// (spheres at x = 2^i), median splits add at most log2(count / 4)
+		static const int MAX_SAH_DEPTH = 32;
+
+		// Traversal stack entries, a tree is at most MAX_SAH_DEPTH + 30
+		// levels deep (2^32 primitives) and needs one entry per level plus one
+		static const int STACK_SIZE = 64;
+
+		// Primitive arrays
+		std::vector<sphere_prim> spheres;
+		std::vector<moving_sphere_prim> moving_spheres;
+		std::vector<const Hittable*> objects;
+		std::vector<std::shared_ptr<Hittable>> owned;		// Objects added by shared_ptr, kept alive here
+
+		// Materials and objects made with add_material/emplace
+		Arena arena;
+
+		// Flat BVH, soa spheres and object refs are in leaf order
+		std::vector<flat_node> nodes;
+		sphere_soa soa;
+		std::vector<prim_ref> refs;
+		aabb bbox;
+		bool motion;
+
+		// Lights, as SoA sphere indices, and the running sum of their
+		// share of the total power for picking one
+		std::vector<std::uint32_t> lights;
+		std::vector<real> light_cdf;
+		std::vector<std::int32_t> sphere_light;	// Light index per SoA sphere, -1 for non lights
+
+		// Environment, the light after the spheres in light_cdf when it gives off anything
+		std::shared_ptr<const EnvironmentMap> env;
+		bool env_light;
+
+		/**
+		* Build Recursive
+		*
+		* @param prims	Build primitives, reordered in place
+		* @param start	Start of the range
+		* @param end	End of the range
+		* @param depth	Depth of the created node, the root is 0
+		*
+		* @return Index of the created node
+		*/
+		std::uint32_t build_recursive(std::vector<build_prim>& prims, size_t start, size_t end, int depth);
+
+		/**
+		* Traverse
+		* Single ray walk of the subtree under root
+		*
+		* @param root	Node to start from
+		* @param r		Ray
+		* @param ray_t	Interval (time) of ray r, max is shrunk with every hit
+		* @param info	Closest hit, only written to on a hit
+		*
+		* @return Whether anything was hit
+		*/
+		bool traverse(std::uint32_t root, const ray& r, Interval& ray_t, hit_info& info) const;
+
+		/**
+		* Build Lights
+		* Finds the light spheres in the SoA, adds the environment, and
+		* works out light_cdf. Needs the scene's bounds
+		*/
+		void build_lights();
+
+		/**
+		* Light Pick PDF
+		*
+		* @param k	Light index
+		*
+		* @return Chance sample_light picks light k
+		*/
+		real light_pick_pdf(size_t k) const;
+
+		/**
+		* Sphere Record
+		* Fills in the full hit record for the closest sphere
+		*
+		* @param index	Sphere index in the SoA
+		* @param r		Ray
+		* @param t		Where along r the sphere was hit
+		* @param rec	Hit Record
+		*/
+		void sphere_record(std::uint32_t index, const ray& r, real t, hit_record& rec) const;
+	};
+
+}
+
+#endif // !SCENE_H
@@ -9,7 +9,6 @@
 #include "vec3.hpp"
 #include "ray.h"
 #include "interval.h"
-#include "material.hpp"
 
 namespace rtw {
 
@@ -28,10 +27,10 @@ namespace rtw {
 		* 
 		* @param center		Center of the sphere
 		* @param radius		Radius of the sphere
-		* @param mat		Material of the sphere
+		* @param mat		Material of the sphere (index into the MaterialTable)
 		*/
-		Sphere(const point3& center, double radius, std::shared_ptr<material> mat)
-			: center1(center), radius(std::fmax(0, radius)), mat(mat), is_moving(false) {
+		Sphere(const point3& center, real radius, mat_id mat)
+			: center1(center), radius(std::fmax(real(0), radius)), mat(mat), is_moving(false) {
 		
 			auto rvec = vec3(radius, radius, radius);
 			bbox = aabb(center1 - rvec, center1 + rvec);
@@ -43,10 +42,10 @@ namespace rtw {
 		* @param center1	Starting center
 		* @param center2	Ending center
 		* @param radius		Radius
-		* @param mat		Material of the sphere
+		* @param mat		Material of the sphere (index into the MaterialTable)
 		*/
-		Sphere(const point3& center1, const point3& center2, double radius, std::shared_ptr<material> mat)
-			: center1(center1), radius(std::fmax(0, radius)), mat(mat), is_moving(true) {
+		Sphere(const point3& center1, const point3& center2, real radius, mat_id mat)
+			: center1(center1), radius(std::fmax(real(0), radius)), mat(mat), is_moving(true) {
 
 			auto rvec = vec3(radius, radius, radius);
 			aabb box1(center1 - rvec, center1 + rvec);
@@ -64,36 +63,72 @@ namespace rtw {
 		* @param rec	Hit Record of the sphere
 		*/
 		bool hit(const ray& r, Interval ray_t, hit_record& rec) const override {
+			hit_info info;
+			if (!intersect(r, ray_t, info)) { return false; }
+
+			interaction(r, info, rec);
+			return true;
+		}
+
+		/**
+		* Intersect
+		* 
+		* @param r		Ray
+		* @param ray_t	Ray (time) Interval
+		* @param info	Closest hit, t only
+		*/
+		bool intersect(const ray& r, Interval ray_t, hit_info& info) const override {
 			// Center calculation based of movement
 			point3 center = is_moving ? sphere_center(r.time()) : center1;
 
 			// Most the needed calculations for if a point lies within/on the surface of a sphere
+			// Discriminant and roots use the stable forms (Ray Tracing Gems ch. 7),
+			// h^2 - a*c and h - sqrtd both cancel badly in float
 			vec3 oc = center - r.origin();
 			auto a = r.direction().length_squared();
 			auto h = dot(r.direction(), oc);
 			auto c = oc.length_squared() - radius * radius;
-			auto discriminant = h * h - a * c;
+			auto discriminant = a * (radius * radius - (oc - (h / a) * r.direction()).length_squared());
 
 			if (discriminant < 0) { return false; }
 
-			auto sqrtd = std::sqrt(discriminant);
+			auto q = h + std::copysign(std::sqrt(discriminant), h);
+			auto root0 = c / q, root1 = q / a;
 
-			auto root = (h - sqrtd) / a;
+			auto root = std::fmin(root0, root1);
 			if (!ray_t.surrounds(root)) {
-				root = (h + sqrtd) / a;
+				root = std::fmax(root0, root1);
 				if (!ray_t.surrounds(root)) {
 					return false;
 				}
 			}
 
+			info.t = root;
+			info.object = this;
+			info.prim = 0;
+			return true;
+		}
+
+		/**
+		* Interaction
+		* 
+		* @param r		Ray
+		* @param info	Hit found by intersect
+		* @param rec	Hit Record of the sphere
+		*/
+		void interaction(const ray& r, const hit_info& info, hit_record& rec) const override {
+			point3 center = is_moving ? sphere_center(r.time()) : center1;
+
 			// Hit Record settings
-			rec.t = root;
-			rec.p = r.at(rec.t);
-			vec3 outward_normal = (rec.p - center) / radius;
+			// The point is pushed back onto the surface, r.at(t) alone picks
+			// up all of t's error, and what's left is bounded for offset_ray_origin
+			rec.t = info.t;
+			vec3 outward_normal = unit_vector(r.at(rec.t) - center);
+			vec3 radial = radius * outward_normal;
+			rec.p = center + radial;
+			rec.p_error = gamma_bound<real>(6) * (abs(center) + abs(radial));
 			rec.set_face_normal(r, outward_normal);
 			rec.mat = mat;
-
-			return true;
 		}
 
 		/**
@@ -103,10 +138,26 @@ namespace rtw {
 		*/
 		aabb bounding_box() const override { return bbox; }
 
+		/**
+		* Bounding Box at Time
+		* Moving spheres are boxed around their center at that time
+		* 
+		* @param time	Ray time
+		* 
+		* @return The Bounding Box at the given time
+		*/
+		aabb bounding_box_at(real time) const override {
+			if (!is_moving) { return bbox; }
+
+			auto rvec = vec3(radius, radius, radius);
+			point3 center = sphere_center(time);
+			return aabb(center - rvec, center + rvec);
+		}
+
 	private:
 		point3 center1;
-		double radius;
-		std::shared_ptr<material> mat;
+		real radius;
+		mat_id mat;
 		bool is_moving;
 		vec3 center_vec;
 		aabb bbox;
@@ -120,7 +171,7 @@ namespace rtw {
 		* 
 		* @param time Time along difference
 		*/
-		point3 sphere_center(double time) const {
+		point3 sphere_center(real time) const {
 			return center1 + time * center_vec;
 		}
 	};
@@ -0,0 +1,103 @@
+// sphere_kernel.h - Declaration of the sphere_soa struct and the SIMD sphere kernel
+// Ethan Rudy
+
+#ifndef SPHERE_KERNEL_H
+#define SPHERE_KERNEL_H
+
+#include "consts.hpp"
+#include "cpu.h"
+#include "hittable.hpp"
+#include "ray.h"
+#include <cstdint>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Sphere Structure of Arrays
+	*
+	* Every sphere in the scene, one array per component, in BVH
+	* leaf order so a leaf's spheres sit next to each other.
+	* Static spheres are just moving spheres with zero velocity.
+	*/
+	struct sphere_soa {
+		// Widest SIMD path (16 floats with AVX-512), arrays are padded by
+		// this much so the last group of spheres can always be loaded whole
+		static const int PADDING = 16;
+
+		std::vector<real> cx, cy, cz;		// Center at time 0
+		std::vector<real> vx, vy, vz;		// Center at time 1 - center at time 0
+		std::vector<real> radius;
+		std::vector<mat_id> mat;
+
+		/**
+		* Push Back
+		*
+		* @param center		Center at time 0
+		* @param velocity	Movement over the shutter
+		* @param r			Radius
+		* @param m			Material
+		*/
+		void push_back(const point3& center, const vec3& velocity, real r, mat_id m);
+
+		/**
+		* Pad
+		* Adds PADDING dummy spheres to the end, run after the last push_back
+		*/
+		void pad();
+
+		/**
+		* Clear
+		*/
+		void clear();
+
+		/**
+		* Center
+		*
+		* @param i		Sphere index
+		* @param time	Ray time
+		*
+		* @return Center of sphere i at the given time
+		*/
+		point3 center(std::uint32_t i, real time) const;
+	};
+
+	/**
+	* Intersect Spheres
+	*
+	* Tests one ray against spheres [first, first + count) several at a
+	* time. The widest version the host CPU runs is picked on the first
+	* call (see host_simd_level), so one binary uses AVX-512 on
+	* Skylake-X, AVX2 on Haswell/Zen and SSE2 anywhere else. Only the
+	* closest t and its index are kept, the hit record gets built once
+	* by the caller for whichever sphere ends up closest overall.
+	*
+	* @param s		Spheres
+	* @param first	First sphere to test
+	* @param count	Number of spheres to test
+	* @param r		Ray
+	* @param t_min	Closest allowed t
+	* @param t_max	Farthest allowed t, shrunk to the hit's t when something is hit
+	*
+	* @return Index of the closest sphere hit, or -1 if none were
+	*/
+	int intersect_spheres(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max);
+
+	// Per instruction set versions of intersect_spheres, scalar and SSE2
+	// live in sphere_kernel.cpp, the rest in sphere_kernel_<isa>.cpp
+	// files built for that instruction set. Only call one the host CPU supports
+	int intersect_spheres_scalar(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max);
+#ifdef RTW_X86
+	int intersect_spheres_sse2(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max);
+	int intersect_spheres_avx2(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max);
+	int intersect_spheres_avx512(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max);
+#endif
+
+}
+
+#endif // !SPHERE_KERNEL_H
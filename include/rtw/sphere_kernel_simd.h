@@ -0,0 +1,106 @@
+// sphere_kernel_simd.h - Implementation of the SIMD sphere kernel, shared by every instruction set
+// Ethan Rudy
+
+#ifndef SPHERE_KERNEL_SIMD_H
+#define SPHERE_KERNEL_SIMD_H
+
+// Only for the sphere_kernel*.cpp files. Each includes this after its
+// '#pragma GCC target', so the template is compiled for that file's
+// instruction set, and instantiates it with traits from an unnamed
+// namespace, so the copies can never be merged across files.
+// Everything else (standard headers included) has to be included
+// before the pragma.
+
+namespace rtw {
+
+	/**
+	* Intersect Spheres (SIMD)
+	* S::WIDTH spheres per iteration, S wraps the intrinsics for one
+	* instruction set and scalar type:
+	*	reg, mask, WIDTH, set1, load, store, lanes,
+	*	add, sub, mul, div, sqrt, min, max,
+	*	lt, gt, ge (-> mask), both (mask & mask), select, any, copysign
+	*
+	* Roots come from the numerically stable form of the quadratic
+	* (Ray Tracing Gems ch. 7), float loses too much to cancellation
+	* with the textbook one for small or far away spheres
+	*
+	* Same parameters and return as intersect_spheres
+	*/
+	template <typename S>
+	inline int intersect_spheres_simd(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max) {
+
+		using reg = typename S::reg;
+		using mask = typename S::mask;
+		using scalar = typename S::scalar;
+
+		const point3& o = r.origin();
+		const vec3& d = r.direction();
+
+		const reg ox = S::set1(o[0]), oy = S::set1(o[1]), oz = S::set1(o[2]);
+		const reg dx = S::set1(d[0]), dy = S::set1(d[1]), dz = S::set1(d[2]);
+		const reg time = S::set1(r.time());
+		const reg a = S::set1(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		const reg lo = S::set1(t_min);
+		const reg inf = S::set1(scalar(INF));
+		const reg zero = S::set1(0);
+		const reg lane = S::lanes();
+
+		int best = -1;
+		for (std::uint32_t i = 0; i < count; i += S::WIDTH) {
+			std::uint32_t base = first + i;
+
+			// Center at the ray's time, relative to the ray origin
+			reg ocx = S::sub(S::add(S::load(&s.cx[base]), S::mul(time, S::load(&s.vx[base]))), ox);
+			reg ocy = S::sub(S::add(S::load(&s.cy[base]), S::mul(time, S::load(&s.vy[base]))), oy);
+			reg ocz = S::sub(S::add(S::load(&s.cz[base]), S::mul(time, S::load(&s.vz[base]))), oz);
+			reg rad2 = S::mul(S::load(&s.radius[base]), S::load(&s.radius[base]));
+
+			reg h = S::add(S::add(S::mul(dx, ocx), S::mul(dy, ocy)), S::mul(dz, ocz));
+			reg c = S::sub(S::add(S::add(S::mul(ocx, ocx), S::mul(ocy, ocy)), S::mul(ocz, ocz)), rad2);
+
+			// Discriminant as a * (r^2 - |oc - (h / a) d|^2), no h^2 - a c cancellation
+			reg b = S::div(h, a);
+			reg lx = S::sub(ocx, S::mul(b, dx));
+			reg ly = S::sub(ocy, S::mul(b, dy));
+			reg lz = S::sub(ocz, S::mul(b, dz));
+			reg discriminant = S::mul(a, S::sub(rad2, S::add(S::add(S::mul(lx, lx), S::mul(ly, ly)), S::mul(lz, lz))));
+			reg sqrtd = S::sqrt(S::max(discriminant, zero));
+
+			// Roots without subtracting nearly equal values
+			reg q = S::add(h, S::copysign(sqrtd, h));
+			reg root0 = S::div(c, q);
+			reg root1 = S::div(q, a);
+			reg near = S::min(root0, root1);
+			reg far = S::max(root0, root1);
+
+			// Near root if it's in range, else far root if it's in range, else INF
+			reg hi = S::set1(t_max);
+			mask in_near = S::both(S::gt(near, lo), S::lt(near, hi));
+			mask in_far = S::both(S::gt(far, lo), S::lt(far, hi));
+			reg t = S::select(in_near, near, S::select(in_far, far, inf));
+
+			// Drop misses and lanes past the end of the range
+			mask valid = S::both(S::ge(discriminant, zero), S::lt(lane, S::set1(scalar(count - i))));
+			t = S::select(valid, t, inf);
+
+			// Any lane closer than what we have?
+			if (!S::any(S::lt(t, hi))) { continue; }
+
+			scalar tv[S::WIDTH];
+			S::store(tv, t);
+			for (int l = 0; l < S::WIDTH; ++l) {
+				if (tv[l] < t_max) {
+					t_max = tv[l];
+					best = int(base + l);
+				}
+			}
+		}
+
+		return best;
+	}
+
+}
+
+#endif // !SPHERE_KERNEL_SIMD_H
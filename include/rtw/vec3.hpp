@@ -6,176 +6,436 @@
 
 #include "consts.hpp"
 
+#if defined(RTW_SIMD_VEC3) && (defined(__SSE2__) || defined(_M_X64) || defined(__AVX__))
+#include <immintrin.h>
+#endif
+
 namespace rtw {
 
 	// 3D Vector Class
-	class vec3 {
+	// Templated on the scalar type, vec3 is the 'real' (render path) version
+	//
+	// With RTW_SIMD_VEC3 defined, a vector is stored as 4 aligned lanes
+	// (the last always 0) so it loads/stores as a single SSE (float) or
+	// AVX (double) register, and the arithmetic operators below get
+	// intrinsic versions for whatever the build targets
+	template <typename T>
+	class basic_vec3 {
 	public:
+		// Scalar type
+		using value_type = T;
+
+#ifdef RTW_SIMD_VEC3
+		// Storage lanes
+		static const int LANES = 4;
+
+		// Elements (e[3] is padding)
+		alignas(4 * sizeof(T)) T e[LANES];
+#else
+		// Storage lanes
+		static const int LANES = 3;
+
 		// Elements
-		double e[3];
+		T e[LANES];
+#endif
 
 		/**
 		* Default Constructor
 		*/
-		vec3();
+		basic_vec3();
 
 		/**
 		* Element Constructor
-		* 
+		*
 		* @parm e0	First (x) component
 		* @parm e1	Second (y) component
 		* @parm e2	Third (z) component
 		*/
-		vec3(double e0, double e1, double e2);
+		basic_vec3(T e0, T e1, T e2);
 
 		// Accessors
-		double x() const;
-		double y() const;
-		double z() const;
+		T x() const;
+		T y() const;
+		T z() const;
 
 		// Negate Operator
-		vec3 operator-() const;
+		basic_vec3 operator-() const;
 
 		// Accessors (indexed)
-		double operator[](int i) const;
-		double& operator[](int i);
+		T operator[](int i) const;
+		T& operator[](int i);
 
 		// Addition & Assigment
-		vec3& operator+=(const vec3& v);
+		basic_vec3& operator+=(const basic_vec3& v);
 
 		// Scalar Multiplication & Assignment
-		vec3& operator*=(double t);
+		basic_vec3& operator*=(T t);
 
 		// Scalar Division & Assignment
-		vec3& operator/=(double t);
+		basic_vec3& operator/=(T t);
 
 		// Length
-		double length() const;
+		T length() const;
 
 		// Length Squared
-		double length_squared() const;
+		T length_squared() const;
 
 		bool near_zero() const;
 
 		// Random
-		static vec3 random() {
-			return vec3(random_double(), random_double(), random_double());
+		static basic_vec3 random() {
+			return basic_vec3(T(random_double()), T(random_double()), T(random_double()));
 		}
 
-		static vec3 random(double min, double max) {
-			return vec3(random_double(min, max), random_double(min, max), random_double(min, max));
+		static basic_vec3 random(double min, double max) {
+			return basic_vec3(T(random_double(min, max)), T(random_double(min, max)), T(random_double(min, max)));
 		}
 
 	};
 
-	// Alternate Naming conventions, 3d point, and 3 channel rgb color
+	// Render path vector, 3d point, and 3 channel rgb color
+	using vec3 = basic_vec3<real>;
 	using point3 = vec3;
 	using color = vec3;
 
+	// Fixed precision versions
+	using vec3f = basic_vec3<float>;
+	using vec3d = basic_vec3<double>;
+
+	// Scalars are taken as value_type so '2 * v' works for any T
+	// (a plain T would have to be deduced from both sides)
+	template <typename T>
+	using scalar_of = typename basic_vec3<T>::value_type;
+
+
+
+	// Members are defined here rather than in vec3.cpp, they're called from
+	// every intersection and scatter and a call each was most of the cost
+
+	// Default Constructor
+	template <typename T>
+	inline basic_vec3<T>::basic_vec3() : e{} {}
+
+	// Element Constructor
+	template <typename T>
+	inline basic_vec3<T>::basic_vec3(T e0, T e1, T e2) : e{ e0, e1, e2 } {}
+
+	// Accessors
+	template <typename T> inline T basic_vec3<T>::x() const { return e[0]; }
+	template <typename T> inline T basic_vec3<T>::y() const { return e[1]; }
+	template <typename T> inline T basic_vec3<T>::z() const { return e[2]; }
+
+	// Negate Operator
+	template <typename T>
+	inline basic_vec3<T> basic_vec3<T>::operator-() const { return basic_vec3(-e[0], -e[1], -e[2]); }
+
+	// Accessors (indexed)
+	template <typename T> inline T basic_vec3<T>::operator[](int i) const { return e[i]; }
+	template <typename T> inline T& basic_vec3<T>::operator[](int i) { return e[i]; }
+
+	// Addition & Assigment
+	template <typename T>
+	inline basic_vec3<T>& basic_vec3<T>::operator+=(const basic_vec3& v) {
+		e[0] += v.e[0];
+		e[1] += v.e[1];
+		e[2] += v.e[2];
+
+		return *this;
+	}
+
+	// Scalar Multiplication & Assignment
+	template <typename T>
+	inline basic_vec3<T>& basic_vec3<T>::operator*=(T t) {
+		e[0] *= t;
+		e[1] *= t;
+		e[2] *= t;
+
+		return *this;
+	}
+
+	// Scalar Division & Assignment
+	template <typename T>
+	inline basic_vec3<T>& basic_vec3<T>::operator/=(T t) {
+		return *this *= 1 / t;
+	}
+
+	// Length
+	template <typename T>
+	inline T basic_vec3<T>::length() const {
+		return std::sqrt(length_squared());
+	}
+
+	// Length Squared
+	template <typename T>
+	inline T basic_vec3<T>::length_squared() const {
+		return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+	}
+
 	// Ostream Overload
-	inline std::ostream& operator<<(std::ostream& out, const vec3& v) {
+	template <typename T>
+	inline std::ostream& operator<<(std::ostream& out, const basic_vec3<T>& v) {
 		return out << v.e[0] << ' ' << v.e[1] << ' ' << v.e[2];
 	}
 
 	// Addition Operator Overload
-	inline vec3 operator+(const vec3& u, const vec3& v) {
-		return vec3(u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]);
+	template <typename T>
+	inline basic_vec3<T> operator+(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+		return basic_vec3<T>(u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]);
 	}
 
 	// Subtraction Operator Overload
-	inline vec3 operator-(const vec3& u, const vec3& v) {
-		return vec3(u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]);
+	template <typename T>
+	inline basic_vec3<T> operator-(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+		return basic_vec3<T>(u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]);
 	}
 
 	// Multiplication overload
-	inline vec3 operator*(const vec3& u, const vec3& v) {
-		return vec3(u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]);
+	template <typename T>
+	inline basic_vec3<T> operator*(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+		return basic_vec3<T>(u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]);
 	}
 
 	// Multiplication overload (scalar, type 1)
-	inline vec3 operator*(double t, const vec3& v) {
-		return vec3(t * v.e[0], t * v.e[1], t * v.e[2]);
+	template <typename T>
+	inline basic_vec3<T> operator*(scalar_of<T> t, const basic_vec3<T>& v) {
+		return basic_vec3<T>(t * v.e[0], t * v.e[1], t * v.e[2]);
 	}
 
 	// Multiplication overload (scalar, type 2)
-	inline vec3 operator*(const vec3& v, double t) {
+	template <typename T>
+	inline basic_vec3<T> operator*(const basic_vec3<T>& v, scalar_of<T> t) {
 		return t * v;
 	}
 
 	// Division overload
-	inline vec3 operator/(const vec3& v, double t) {
+	template <typename T>
+	inline basic_vec3<T> operator/(const basic_vec3<T>& v, scalar_of<T> t) {
 		return (1 / t) * v;
 	}
 
 	// Dot Product
-	inline double dot(const vec3& u, const vec3& v) {
+	template <typename T>
+	inline T dot(const basic_vec3<T>& u, const basic_vec3<T>& v) {
 		return u.e[0] * v.e[0]
 			+ u.e[1] * v.e[1]
 			+ u.e[2] * v.e[2];
 	}
 
 	// Cross Product
-	inline vec3 cross(const vec3& u, const vec3& v) {
-		return vec3(u.e[1] * v.e[2] - u.e[2] * v.e[1],
+	template <typename T>
+	inline basic_vec3<T> cross(const basic_vec3<T>& u, const basic_vec3<T>& v) {
+		return basic_vec3<T>(u.e[1] * v.e[2] - u.e[2] * v.e[1],
 			u.e[2] * v.e[0] - u.e[0] * v.e[2],
 			u.e[0] * v.e[1] - u.e[1] * v.e[0]);
 	}
 
+
+
+#if defined(RTW_SIMD_VEC3) && (defined(__SSE2__) || defined(_M_X64))
+
+	// SSE versions for float, one vector per __m128
+	// SSE2 is part of x86-64 so these never need a runtime check
+
+	template <>
+	inline vec3f vec3f::operator-() const {
+		vec3f r;
+		_mm_store_ps(r.e, _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(e)));
+		return r;
+	}
+
+	template <>
+	inline vec3f& vec3f::operator+=(const vec3f& v) {
+		_mm_store_ps(e, _mm_add_ps(_mm_load_ps(e), _mm_load_ps(v.e)));
+		return *this;
+	}
+
+	template <>
+	inline vec3f& vec3f::operator*=(float t) {
+		_mm_store_ps(e, _mm_mul_ps(_mm_load_ps(e), _mm_set1_ps(t)));
+		return *this;
+	}
+
+	template <>
+	inline vec3f operator+(const vec3f& u, const vec3f& v) {
+		vec3f r;
+		_mm_store_ps(r.e, _mm_add_ps(_mm_load_ps(u.e), _mm_load_ps(v.e)));
+		return r;
+	}
+
+	template <>
+	inline vec3f operator-(const vec3f& u, const vec3f& v) {
+		vec3f r;
+		_mm_store_ps(r.e, _mm_sub_ps(_mm_load_ps(u.e), _mm_load_ps(v.e)));
+		return r;
+	}
+
+	template <>
+	inline vec3f operator*(const vec3f& u, const vec3f& v) {
+		vec3f r;
+		_mm_store_ps(r.e, _mm_mul_ps(_mm_load_ps(u.e), _mm_load_ps(v.e)));
+		return r;
+	}
+
+	template <>
+	inline vec3f operator*(float t, const vec3f& v) {
+		vec3f r;
+		_mm_store_ps(r.e, _mm_mul_ps(_mm_set1_ps(t), _mm_load_ps(v.e)));
+		return r;
+	}
+
+#endif
+
+#if defined(RTW_SIMD_VEC3) && defined(__AVX__)
+
+	// AVX versions for double, one vector per __m256d
+	// Only when the build itself targets AVX, inline code can't be
+	// dispatched at runtime (the hot kernels are, see cpu.h)
+
+	template <>
+	inline vec3d vec3d::operator-() const {
+		vec3d r;
+		_mm256_store_pd(r.e, _mm256_sub_pd(_mm256_setzero_pd(), _mm256_load_pd(e)));
+		return r;
+	}
+
+	template <>
+	inline vec3d& vec3d::operator+=(const vec3d& v) {
+		_mm256_store_pd(e, _mm256_add_pd(_mm256_load_pd(e), _mm256_load_pd(v.e)));
+		return *this;
+	}
+
+	template <>
+	inline vec3d& vec3d::operator*=(double t) {
+		_mm256_store_pd(e, _mm256_mul_pd(_mm256_load_pd(e), _mm256_set1_pd(t)));
+		return *this;
+	}
+
+	template <>
+	inline vec3d operator+(const vec3d& u, const vec3d& v) {
+		vec3d r;
+		_mm256_store_pd(r.e, _mm256_add_pd(_mm256_load_pd(u.e), _mm256_load_pd(v.e)));
+		return r;
+	}
+
+	template <>
+	inline vec3d operator-(const vec3d& u, const vec3d& v) {
+		vec3d r;
+		_mm256_store_pd(r.e, _mm256_sub_pd(_mm256_load_pd(u.e), _mm256_load_pd(v.e)));
+		return r;
+	}
+
+	template <>
+	inline vec3d operator*(const vec3d& u, const vec3d& v) {
+		vec3d r;
+		_mm256_store_pd(r.e, _mm256_mul_pd(_mm256_load_pd(u.e), _mm256_load_pd(v.e)));
+		return r;
+	}
+
+	template <>
+	inline vec3d operator*(double t, const vec3d& v) {
+		vec3d r;
+		_mm256_store_pd(r.e, _mm256_mul_pd(_mm256_set1_pd(t), _mm256_load_pd(v.e)));
+		return r;
+	}
+
+#endif
+
+
+
 	// Unit Vector
-	inline vec3 unit_vector(const vec3& v) {
+	template <typename T>
+	inline basic_vec3<T> unit_vector(const basic_vec3<T>& v) {
 		return v / v.length();
 	}
 
-	// Random Vector in Unit Disk
-	// 2D vector, where the z component is 0
-	inline vec3 random_in_unit_disk() {
-		while (true) {
-			auto p = vec3(random_double(-1, 1), random_double(-1, 1), 0);
-			if (p.length_squared() < 1) {
-				return p;
-			}
-		}
+	// Absolute value of each component
+	template <typename T>
+	inline basic_vec3<T> abs(const basic_vec3<T>& v) {
+		return basic_vec3<T>(std::fabs(v.e[0]), std::fabs(v.e[1]), std::fabs(v.e[2]));
 	}
 
-	// Random Vector in Unit Sphere
-	inline vec3 random_in_unit_shpere() {
-		while (true) {
-			auto p = vec3::random(-1, 1);
-			if (p.length_squared() < 1) {
-				return p;
-			}
-		}
+	// Sampling
+	// Closed form mappings from uniform samples (u.x, u.y in [0, 1)) to
+	// directions and points. Each takes a fixed number of sample
+	// dimensions and has no loops or data dependent branches (the
+	// selects compile to blends), so they also vectorize when called
+	// over arrays of samples
+
+	// Unit Vector, uniform over the sphere
+	inline vec3 sample_unit_vector(const vec3& u) {
+		real z = 1 - 2 * u.x();
+		real r = std::sqrt(std::fmax(real(0), 1 - z * z));
+		real phi = real(2 * PI) * u.y();
+		return vec3(r * std::cos(phi), r * std::sin(phi), z);
 	}
 
-	// Random unit Vector
-	inline vec3 random_unit_vector() {
-		return unit_vector(random_in_unit_shpere());
+	// Point in the Unit Disk, z component is 0
+	// Concentric mapping (Shirley and Chiu), squares of samples stay
+	// roughly square on the disk so stratification survives
+	inline vec3 sample_in_unit_disk(const vec3& u) {
+		real a = 2 * u.x() - 1;
+		real b = 2 * u.y() - 1;
+
+		// Which of the four wedges the point is in, by its largest coordinate
+		bool horizontal = a * a > b * b;
+		real r = horizontal ? a : b;
+		real divisor = r == 0 ? real(1) : r;
+		real theta = horizontal
+			? real(PI / 4) * (b / divisor)
+			: real(PI / 2) - real(PI / 4) * (a / divisor);
+
+		return vec3(r * std::cos(theta), r * std::sin(theta), 0);
 	}
 
-	// Random Vector on Hemisphere
-	inline vec3 random_on_hemisphere(const vec3& normal) {
-		vec3 on_unit_sphere = random_unit_vector();
-		if (dot(on_unit_sphere, normal) > 0.0) {
-			return on_unit_sphere;
-		}
-		else {
-			return -on_unit_sphere;
-		}
+	// Cosine weighted direction around +z
+	// Point on the disk, lifted up onto the hemisphere (Malley's method)
+	inline vec3 sample_cosine_hemisphere(const vec3& u) {
+		vec3 d = sample_in_unit_disk(u);
+		real z = std::sqrt(std::fmax(real(0), 1 - d.x() * d.x() - d.y() * d.y()));
+		return vec3(d.x(), d.y(), z);
+	}
+
+	/**
+	* Orthonormal Basis
+	* Two unit vectors perpendicular to n and each other, without
+	* branching on which axis n is closest to (Duff et al. 2017,
+	* "Building an Orthonormal Basis, Revisited")
+	*
+	* @param n	Unit vector
+	* @param b1	First tangent (ref)
+	* @param b2	Second tangent (ref)
+	*/
+	inline void orthonormal_basis(const vec3& n, vec3& b1, vec3& b2) {
+		real sign = std::copysign(real(1), n.z());
+		real a = -1 / (sign + n.z());
+		real b = n.x() * n.y() * a;
+		b1 = vec3(1 + sign * n.x() * n.x() * a, sign * b, -sign * n.x());
+		b2 = vec3(b, sign + n.y() * n.y() * a, -n.y());
+	}
+
+	// Cosine weighted direction around a unit normal, unit length
+	inline vec3 sample_cosine_direction(const vec3& normal, const vec3& u) {
+		vec3 b1, b2;
+		orthonormal_basis(normal, b1, b2);
+		vec3 d = sample_cosine_hemisphere(u);
+		return d.x() * b1 + d.y() * b2 + d.z() * normal;
 	}
 
 	// Reflect Vector
-	inline vec3 reflect(const vec3& v, const vec3& n) {
+	template <typename T>
+	inline basic_vec3<T> reflect(const basic_vec3<T>& v, const basic_vec3<T>& n) {
 		return v - 2 * dot(v, n) * n;
 	}
 
 	// Refract Vector
-	inline vec3 refract(const vec3& uv, const vec3& n, double etai_over_etat) {
-		auto cos_theta = std::fmin(dot(-uv, n), 1.0);
-		vec3 r_out_perp = etai_over_etat * (uv + cos_theta * n);
-		vec3 r_out_parallel = -std::sqrt(std::fabs(1.0 - r_out_perp.length_squared())) * n;
+	template <typename T>
+	inline basic_vec3<T> refract(const basic_vec3<T>& uv, const basic_vec3<T>& n, scalar_of<T> etai_over_etat) {
+		auto cos_theta = std::fmin(dot(-uv, n), T(1));
+		basic_vec3<T> r_out_perp = etai_over_etat * (uv + cos_theta * n);
+		basic_vec3<T> r_out_parallel = -std::sqrt(std::fabs(1 - r_out_perp.length_squared())) * n;
 		return r_out_perp + r_out_parallel;
 	}
 
 }
 
-#endif // !VEC3_H
\ No newline at end of file
+#endif // !VEC3_H
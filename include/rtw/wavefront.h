@@ -0,0 +1,185 @@
+// wavefront.h - Declaration of the Wavefront class
+// Ethan Rudy
+
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include "consts.hpp"
+#include "ray.h"
+#include "interval.h"
+#include "hittable.hpp"
+#include "material.hpp"
+#include "material_table.h"
+#include "path_guide.h"
+#include "scene.h"
+#include <cstdint>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Wavefront class
+	*
+	* Alternative to Camera::ray_color's one path at a time recursion.
+	* A whole batch of paths is carried along together, one bounce at
+	* a time, in stages:
+	*
+	*	reorder		(optional, bounces after the first) paths sorted by
+	*				direction octant, then origin along a Morton curve, so
+	*				neighbouring paths walk the same part of the BVH
+	*	intersect	every path against the scene, misses pick up the sky
+	*	sort		hits grouped by material kind (counting sort)
+	*	shade		each kind in its own loop, calling the final
+	*				class's scatter directly instead of through the vtable,
+	*				after adding emission and sampling the lights, then
+	*				Russian roulette on the new throughput
+	*	compact		surviving paths packed to the front for the next bounce
+	*
+	* Paths are generated by whoever owns the batch (see
+	* Camera::render_span_wavefront), which also owns the pixel colors
+	* the paths add into. Path state is a structure of arrays, so the
+	* per stage loops only touch what they need.
+	*
+	* Not thread safe, every render thread keeps its own.
+	*/
+	class Wavefront {
+	public:
+
+		// Paths per batch, enough to keep each stage's loop busy
+		// while the state still stays in L2
+		static const size_t BATCH_SIZE = 1 << 14;
+
+		// Whether to run the reorder stage before each secondary bounce
+		bool reorder = false;
+
+		// Path guide lambertian bounces sample with (see Camera::guided_scatter), null for none
+		// Only sampled from, training goes through Camera::render_span
+		const PathGuide* guide = nullptr;
+
+		/**
+		* Default Constructor
+		*/
+		Wavefront();
+
+		/**
+		* Clear
+		* Drops every path, run before generating a new batch
+		*/
+		void clear();
+
+		/**
+		* Add Path
+		*
+		* @param r			Camera ray
+		* @param pixel		Index into the pixel colors given to trace
+		* @param x			Pixel x, for the sampler
+		* @param y			Pixel y, for the sampler
+		* @param sample		Sample index within the pixel
+		* @param dimension	First sample dimension shading uses
+		*/
+		void add(const ray& r, std::uint32_t pixel, int x, int y, int sample, int dimension);
+
+		/**
+		* Size
+		*
+		* @return Number of live paths
+		*/
+		size_t size() const;
+
+		/**
+		* Trace
+		* Runs every path in the batch to completion
+		*
+		* @param world			Scene (objects and materials)
+		* @param max_depth		Most bounces a path can take
+		* @param roulette_depth	Bounces before Russian roulette can end a path (see Camera::russian_roulette)
+		* @param footprint		Angle one camera ray covers, for camera rays that miss (see Camera::sky_color)
+		* @param sampler		Sampler, restarted on each path's sample as it's shaded
+		* @param pixel_colors	Colors the paths add into, indexed by path pixel
+		* @param pixel_albedo	First hit albedos the paths add into, null to skip (see Camera::first_hit_features)
+		* @param pixel_normal	First hit normals the paths add into, null to skip
+		*/
+		void trace(const Scene& world, int max_depth, int roulette_depth, real footprint, Sampler& sampler, color* pixel_colors,
+			color* pixel_albedo = nullptr, vec3* pixel_normal = nullptr);
+
+	private:
+		// Path state, one entry per live path
+		std::vector<real> ox, oy, oz;		// Ray origin
+		std::vector<real> dx, dy, dz;		// Ray direction
+		std::vector<real> time;
+		std::vector<real> tr, tg, tb;		// Throughput, product of the attenuations so far
+		std::vector<real> lr, lg, lb;		// Light picked up so far, added to the pixel when the path ends
+		std::vector<real> bsdf_pdf;			// Density of the last bounce, see Camera::hit_color
+		std::vector<std::uint32_t> pixel;
+		std::vector<std::uint32_t> pixel_x, pixel_y;	// Where the sampler picks up each path
+		std::vector<std::uint32_t> sample_index, sample_dim;
+
+		// Per bounce state
+		std::vector<hit_record> recs;
+		std::vector<std::uint8_t> alive;
+		std::vector<std::uint32_t> order;	// Hit paths, grouped by material kind
+		std::vector<std::uint64_t> keys;	// Reorder sort key (high 32 bits) and path index
+		std::vector<real> scratch;			// Gather space for reordering, one array at a time
+		std::vector<std::uint32_t> scratch_index;
+		size_t kind_start[size_t(material_kind::count) + 1];
+
+		/**
+		* Path Ray
+		*
+		* @param i	Path index
+		*
+		* @return Path i's current ray
+		*/
+		ray path_ray(size_t i) const;
+
+		/**
+		* Reorder
+		* Sorts the paths by direction octant, then by where their origin
+		* falls on a Morton curve through the batch's origin bounds
+		*/
+		void reorder_paths();
+
+		/**
+		* Intersect
+		* Closest hit for every path, paths that miss add the sky and die
+		*
+		* @param world			Scene
+		* @param footprint		Angle each path's ray covers, for the sky lookup
+		* @param pixel_colors	Pixel colors
+		* @param pixel_albedo	Pixel first hit albedos, null unless these are camera rays that want them
+		* @param pixel_normal	Pixel first hit normals, same
+		*/
+		void intersect(const Scene& world, real footprint, color* pixel_colors, color* pixel_albedo, vec3* pixel_normal);
+
+		/**
+		* Sort
+		* Fills order with the paths that hit something, grouped by material kind
+		*
+		* @param materials	Material table
+		*/
+		void sort(const MaterialTable& materials);
+
+		/**
+		* Shade
+		* Shades and scatters the paths of order that hit kind, all of whose materials are an M
+		*
+		* @param world			Scene, for its materials and lights
+		* @param kind			Material kind
+		* @param roulette		Whether Russian roulette can end paths this bounce
+		* @param last			Whether this is the paths' last bounce (see Camera::direct_light)
+		* @param sampler		Sampler
+		* @param pixel_colors	Pixel colors, paths that end here add into them
+		*/
+		template <typename M>
+		void shade(const Scene& world, material_kind kind, bool roulette, bool last, Sampler& sampler, color* pixel_colors);
+
+		/**
+		* Compact
+		* Moves the live paths to the front, keeping their order
+		*/
+		void compact();
+	};
+
+}
+
+#endif // !WAVEFRONT_H
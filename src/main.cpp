@@ -8,6 +8,7 @@
 
 // Standard Header(s)
 #include <iostream>
+#include <string>
 
 // Custom cOpenGL header(s)
 #include "../include/gl/shader.h"
@@ -69,6 +70,9 @@
 *	Once the span threads are complete, the main exec thread will stop
 *	refreshing and writing, leaving the window open until forcefully
 *	closed. Ex: Exited by 'x' button or escape key pressed
+* 
+*	Run with --benchmark to skip all of that: no window, just the
+*	hit vs occluded timings (RayTracer::benchmark) on the scene, then exit
 */
 
 
@@ -94,7 +98,16 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 
 
-int main() {
+int main(int argc, char** argv) {
+	// Benchmark, before any window gets made
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--benchmark") {
+			rtw::RayTracer ray_tracer(WIDTH, HEIGHT);
+			ray_tracer.benchmark();
+			return 0;
+		}
+	}
+
 	// Initialize GLFW
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -6,52 +6,59 @@
 namespace rtw {
 
 	// Default Constructor
-	aabb::aabb() {}
+	template <typename T>
+	basic_aabb<T>::basic_aabb() {}
 
 	// Interval/Side Constructor
-	aabb::aabb(const Interval& x, const Interval& y, const Interval& z)
+	template <typename T>
+	basic_aabb<T>::basic_aabb(const basic_interval<T>& x, const basic_interval<T>& y, const basic_interval<T>& z)
 		: x(x), y(y), z(z) {}
 
 	// Point Constructor
-	aabb::aabb(const point3& a, const point3& b) {
-		x = (a[0] <= b[0]) ? Interval(a[0], b[0]) : Interval(b[0], a[0]);
-		y = (a[1] <= b[1]) ? Interval(a[1], b[1]) : Interval(b[1], a[1]);
-		z = (a[2] <= b[2]) ? Interval(a[2], b[2]) : Interval(b[2], a[2]);
+	template <typename T>
+	basic_aabb<T>::basic_aabb(const basic_vec3<T>& a, const basic_vec3<T>& b) {
+		using I = basic_interval<T>;
+		x = (a[0] <= b[0]) ? I(a[0], b[0]) : I(b[0], a[0]);
+		y = (a[1] <= b[1]) ? I(a[1], b[1]) : I(b[1], a[1]);
+		z = (a[2] <= b[2]) ? I(a[2], b[2]) : I(b[2], a[2]);
 	}
 
 	// Union Constructor
-	aabb::aabb(const aabb& box0, const aabb& box1) {
-		x = Interval(box0.x, box1.x);
-		y = Interval(box0.y, box1.y);
-		z = Interval(box0.z, box1.z);
+	template <typename T>
+	basic_aabb<T>::basic_aabb(const basic_aabb& box0, const basic_aabb& box1) {
+		x = basic_interval<T>(box0.x, box1.x);
+		y = basic_interval<T>(box0.y, box1.y);
+		z = basic_interval<T>(box0.z, box1.z);
 	}
 
 	// Interval / "Side Length" of Axis
-	const Interval& aabb::axis_interval(int n) const {
+	template <typename T>
+	const basic_interval<T>& basic_aabb<T>::axis_interval(int n) const {
 		if (n == 1) { return y; }
 		if (n == 2) { return z; }
 		return x;
 	}
 
 	// Hit
-	bool aabb::hit(const ray& r, Interval ray_t) const {
-		const point3& ray_orig = r.origin();
-		const point3& ray_dir = r.direction();
+	template <typename T>
+	bool basic_aabb<T>::hit(const basic_ray<T>& r, basic_interval<T> ray_t) const {
+		const basic_vec3<T>& ray_orig = r.origin();
+		const basic_vec3<T>& ray_dir = r.direction();
 
 		for (int axis = 0; axis < 3; ++axis) {
-			const Interval& ax = axis_interval(axis);
-			const double adinv = 1.0 / ray_dir[axis];
+			const basic_interval<T>& ax = axis_interval(axis);
+			const T adinv = T(1) / ray_dir[axis];
 
 			auto t0 = (ax.min - ray_orig[axis]) * adinv;
 			auto t1 = (ax.max - ray_orig[axis]) * adinv;
 
 			if (t0 < t1) {
 				if (t0 > ray_t.min) ray_t.min = t0;
-				if (t1 > ray_t.max) ray_t.max = t1;
+				if (t1 < ray_t.max) ray_t.max = t1;
 			}
 			else {
 				if (t1 > ray_t.min) ray_t.min = t1;
-				if (t0 > ray_t.max) ray_t.max = t0;
+				if (t0 < ray_t.max) ray_t.max = t0;
 			}
 
 			if (ray_t.max < ray_t.min) { return false; }
@@ -61,15 +68,51 @@ namespace rtw {
 	}
 
 	// Longest Axis (index)
-	int aabb::longest_axis() const{
+	template <typename T>
+	int basic_aabb<T>::longest_axis() const{
 		if (x.size() > y.size()) {
 			return x.size() > z.size() ? 0 : 2;
 		}
 		return y.size() > z.size() ? 1 : 2;
 	}
 
+	// Surface Area
+	template <typename T>
+	T basic_aabb<T>::surface_area() const {
+		auto dx = x.size(), dy = y.size(), dz = z.size();
+		return 2 * (dx * dy + dy * dz + dz * dx);
+	}
+
+	// Contains Box
+	template <typename T>
+	bool basic_aabb<T>::contains(const basic_aabb& other) const {
+		return x.min <= other.x.min && other.x.max <= x.max
+			&& y.min <= other.y.min && other.y.max <= y.max
+			&& z.min <= other.z.min && other.z.max <= z.max;
+	}
+
+	// Lerp
+	template <typename T>
+	basic_aabb<T> basic_aabb<T>::lerp(const basic_aabb& box0, const basic_aabb& box1, T f) {
+		auto side = [f](const basic_interval<T>& i0, const basic_interval<T>& i1) {
+			return basic_interval<T>(i0.min + f * (i1.min - i0.min), i0.max + f * (i1.max - i0.max));
+		};
+
+		return basic_aabb(side(box0.x, box1.x), side(box0.y, box1.y), side(box0.z, box1.z));
+	}
+
 	// Values of those useful boxes
-	const aabb aabb::empty = aabb(Interval::empty, Interval::empty, Interval::empty);
-	const aabb aabb::universe = aabb(Interval::universe, Interval::universe, Interval::universe);
+	// Built from INF directly, Interval::empty/universe live in another
+	// file and might not be initialized yet when these are
+	template <typename T>
+	const basic_aabb<T> basic_aabb<T>::empty = basic_aabb<T>(
+		basic_interval<T>(T(+INF), T(-INF)), basic_interval<T>(T(+INF), T(-INF)), basic_interval<T>(T(+INF), T(-INF)));
+	template <typename T>
+	const basic_aabb<T> basic_aabb<T>::universe = basic_aabb<T>(
+		basic_interval<T>(T(-INF), T(+INF)), basic_interval<T>(T(-INF), T(+INF)), basic_interval<T>(T(-INF), T(+INF)));
+
+	// The two precisions we ever use
+	template class basic_aabb<float>;
+	template class basic_aabb<double>;
 	
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+// arena.cpp - Implementation of the Arena class
+// Ethan Rudy
+
+#include "../../include/rtw/arena.h"
+#include <cstdint>
+
+namespace rtw {
+
+	// Default Constructor
+	Arena::Arena() {}
+
+	// Destructor
+	Arena::~Arena() {
+		release();
+	}
+
+	// Allocate
+	void* Arena::allocate(size_t size, size_t align) {
+		// Room in the current block (after aligning)?
+		if (!blocks.empty()) {
+			block& b = blocks.back();
+			std::uintptr_t start = reinterpret_cast<std::uintptr_t>(b.data) + b.used;
+			std::uintptr_t aligned = (start + align - 1) & ~std::uintptr_t(align - 1);
+			size_t padding = size_t(aligned - start);
+
+			if (b.used + padding + size <= b.size) {
+				b.used += padding + size;
+				return reinterpret_cast<void*>(aligned);
+			}
+		}
+
+		// New block, big enough for this even at the worst alignment
+		size_t block_size = size + align > BLOCK_SIZE ? size + align : BLOCK_SIZE;
+		blocks.push_back({ static_cast<char*>(::operator new(block_size)), block_size, 0 });
+
+		return allocate(size, align);
+	}
+
+	// Release
+	void Arena::release() {
+		// Newest first, like the stack would
+		for (auto it = dtors.rbegin(); it != dtors.rend(); ++it) {
+			it->destroy(it->object);
+		}
+		dtors.clear();
+
+		for (block& b : blocks) {
+			::operator delete(b.data);
+		}
+		blocks.clear();
+	}
+
+	// Used
+	size_t Arena::used() const {
+		size_t total = 0;
+		for (const block& b : blocks) { total += b.used; }
+		return total;
+	}
+
+}
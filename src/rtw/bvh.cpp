@@ -52,15 +52,28 @@ namespace rtw {
 	}
 
 	// Hit
+	// Only the closest hit's record gets built
 	bool bvh_node::hit(const ray& r, Interval ray_t, hit_record& rec) const {
+		return deferred_hit(r, ray_t, rec);
+	}
+
+	// Intersect
+	bool bvh_node::intersect(const ray& r, Interval ray_t, hit_info& info) const {
 		if (!bbox.hit(r, ray_t)) { return false; }
 
-		bool hit_left = left->hit(r, ray_t, rec);
-		bool hit_right = right->hit(r, Interval(ray_t.min, hit_left ? rec.t : ray_t.max), rec);
+		bool hit_left = left->intersect(r, ray_t, info);
+		bool hit_right = right->intersect(r, Interval(ray_t.min, hit_left ? info.t : ray_t.max), info);
 
 		return hit_left || hit_right;
 	}
 
+	// Occluded
+	bool bvh_node::occluded(const ray& r, Interval ray_t) const {
+		if (!bbox.hit(r, ray_t)) { return false; }
+
+		return left->occluded(r, ray_t) || right->occluded(r, ray_t);
+	}
+
 	// Bounding Box
 	aabb bvh_node::bounding_box() const {
 		return bbox;
@@ -2,6 +2,7 @@
 // Ethan Rudy
 
 #include "../../include/rtw/camera.h"
+#include "../../include/rtw/wavefront.h"
 
 namespace rtw {
 
@@ -13,38 +14,166 @@ namespace rtw {
 	}
 
 	// Render Span (threaded)
-	void Camera::render_span(HittableList& world, int s_start, int s_end, unsigned char* output, std::vector<coord>& pixels, int& n_pixels) {
+	void Camera::render_span(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels) {
+		static const span_fn kernels[2][2] = {
+			{ &Camera::render_tiles<false, false>, &Camera::render_tiles<false, true> },
+			{ &Camera::render_tiles<true, false>, &Camera::render_tiles<true, true> }
+		};
+
+		(this->*kernels[defocus_angle > 0][world.has_motion()])(world, s_start, s_end, output, tiles, n_pixels);
+	}
+
+	// Render Span Wavefront (threaded)
+	void Camera::render_span_wavefront(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels) {
+		static const span_fn kernels[2][2] = {
+			{ &Camera::render_tiles_wavefront<false, false>, &Camera::render_tiles_wavefront<false, true> },
+			{ &Camera::render_tiles_wavefront<true, false>, &Camera::render_tiles_wavefront<true, true> }
+		};
+
+		(this->*kernels[defocus_angle > 0][world.has_motion()])(world, s_start, s_end, output, tiles, n_pixels);
+	}
+
+	// Render Tiles
+	template <bool DEFOCUS, bool MOTION>
+	void Camera::render_tiles(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels) {
+		std::unique_ptr<Sampler> sampler = make_sampler(sampling, seed, samples);
+		ray_packet packet;
+		hit_record recs[ray_packet::MAX_RAYS];
+		color pixel_colors[ray_packet::MAX_RAYS];
+		color pixel_albedo[ray_packet::MAX_RAYS];
+		vec3 pixel_normal[ray_packet::MAX_RAYS];
+
 		// Loop over span
-		for (int coordIndex = s_start; coordIndex < s_end; ++coordIndex) {
-			int x = pixels[coordIndex].x, y = pixels[coordIndex].y;
+		for (int tileIndex = s_start; tileIndex < s_end; ++tileIndex) {
+			const tile& t = tiles[tileIndex];
+			int tile_width = t.x1 - t.x0;
+			int n_tile = tile_width * (t.y1 - t.y0);
 
-			// Sample ray color
-			color pixel_color(0, 0, 0);
+			for (int i = 0; i < n_tile; ++i) {
+				pixel_colors[i] = color(0, 0, 0);
+				pixel_albedo[i] = color(0, 0, 0);
+				pixel_normal[i] = vec3(0, 0, 0);
+			}
+
+			// Sample ray color, one packet per sample
 			for (int sample = 0; sample < samples; sample++) {
-				ray r = get_ray(x, y);
-				pixel_color += ray_color(r, max_depth, world);
+				packet.clear();
+				for (int y = t.y0; y < t.y1; ++y) {
+					for (int x = t.x0; x < t.x1; ++x) {
+						packet.add(get_ray<DEFOCUS, MOTION>(x, y, sample, *sampler));
+					}
+				}
+				packet.finalize();
+
+				if (max_depth <= 0) { continue; }
+
+				std::uint64_t hits = world.hit_packet(packet, Interval(0, INF), recs);
+				for (int i = 0; i < n_tile; ++i) {
+					const ray& r = packet.rays[i];
+					bool hit = (hits & (std::uint64_t(1) << i)) != 0;
+					if (buffers) {
+						color albedo;
+						vec3 normal;
+						first_hit_features(world, r, hit ? &recs[i] : nullptr, albedo, normal);
+						pixel_albedo[i] += albedo;
+						pixel_normal[i] += normal;
+					}
+
+					if (hit) {
+						sampler->start_pixel_sample(t.x0 + i % tile_width, t.y0 + i / tile_width, sample, CAMERA_DIMENSIONS);
+						pixel_colors[i] += hit_color(r, recs[i], max_depth, world, *sampler);
+					}
+					else {
+						pixel_colors[i] += sky_color(world, r, 0, pixel_angle);
+					}
+				}
+			}
+
+			for (int i = 0; i < n_tile; ++i) {
+				write_pixel(output, t.x0 + i % tile_width, t.y0 + i / tile_width, pixel_colors[i]);
+				if (buffers) { write_features(t.x0 + i % tile_width, t.y0 + i / tile_width, pixel_albedo[i], pixel_normal[i]); }
 			}
-			// Scale with weighting
-			pixel_color *= sample_scale;
-
-			// Gamma correction
-			auto r = pixel_color.x();
-			auto g = pixel_color.y();
-			auto b = pixel_color.z();
-			r = linear_to_gamma(r);
-			g = linear_to_gamma(g);
-			b = linear_to_gamma(b);
-
-			// 0 - 255 Clamping * writing to output
-			// This is where color.hpp's write color would
-			// normally be used
-			static const Interval intensity(0.000, 0.999);
-			output[3 * (y * image_width + x) + 0] = int(intensity.clamp(r) * 256);
-			output[3 * (y * image_width + x) + 1] = int(intensity.clamp(g) * 256);
-			output[3 * (y * image_width + x) + 2] = int(intensity.clamp(b) * 256);
 
 			// Increment number of pixels completed (for the progress bar)
-			++n_pixels;
+			n_pixels += n_tile;
+		}
+	}
+
+	// Render Tiles Wavefront
+	template <bool DEFOCUS, bool MOTION>
+	void Camera::render_tiles_wavefront(const Scene& world, int s_start, int s_end, unsigned char* output, std::vector<tile>& tiles, int& n_pixels) {
+		std::unique_ptr<Sampler> sampler = make_sampler(sampling, seed, samples);
+		Wavefront paths;
+		paths.reorder = reorder;
+		paths.guide = guide;
+		std::vector<color> pixel_colors;
+		std::vector<color> pixel_albedo;
+		std::vector<vec3> pixel_normal;
+
+		// Loop over span, a batch of tiles at a time
+		int tileIndex = s_start;
+		while (tileIndex < s_end) {
+			// Take tiles until the next one would overflow the batch (always at least one)
+			int batch_end = tileIndex;
+			size_t n_paths = 0;
+			while (batch_end < s_end) {
+				const tile& t = tiles[batch_end];
+				size_t tile_paths = size_t(t.x1 - t.x0) * (t.y1 - t.y0) * samples;
+				if (batch_end > tileIndex && n_paths + tile_paths > Wavefront::BATCH_SIZE) { break; }
+				n_paths += tile_paths;
+				++batch_end;
+			}
+
+			// A lone tile with too many samples for one batch gets traced a
+			// slice of its samples at a time, all adding into the same pixels
+			int batch_pixels = 0;
+			for (int i = tileIndex; i < batch_end; ++i) { batch_pixels += (tiles[i].x1 - tiles[i].x0) * (tiles[i].y1 - tiles[i].y0); }
+			int sample_step = n_paths > Wavefront::BATCH_SIZE
+				? std::max(1, int(Wavefront::BATCH_SIZE / batch_pixels)) : samples;
+
+			pixel_colors.assign(batch_pixels, color(0, 0, 0));
+			if (buffers) {
+				pixel_albedo.assign(batch_pixels, color(0, 0, 0));
+				pixel_normal.assign(batch_pixels, vec3(0, 0, 0));
+			}
+
+			for (int first_sample = 0; first_sample < samples; first_sample += sample_step) {
+				int last_sample = std::min(first_sample + sample_step, samples);
+
+				// Generate, every sample of the slice for every pixel in the batch
+				std::uint32_t p = 0;
+				for (int i = tileIndex; i < batch_end; ++i) {
+					const tile& t = tiles[i];
+					for (int y = t.y0; y < t.y1; ++y) {
+						for (int x = t.x0; x < t.x1; ++x) {
+							for (int sample = first_sample; sample < last_sample; sample++) {
+								paths.add(get_ray<DEFOCUS, MOTION>(x, y, sample, *sampler), p, x, y, sample, CAMERA_DIMENSIONS);
+							}
+							++p;
+						}
+					}
+				}
+
+				paths.trace(world, max_depth, roulette_depth, pixel_angle, *sampler, pixel_colors.data(),
+					buffers ? pixel_albedo.data() : nullptr, buffers ? pixel_normal.data() : nullptr);
+			}
+
+			// Same walk as generating, to find each pixel again
+			size_t p = 0;
+			for (int i = tileIndex; i < batch_end; ++i) {
+				const tile& t = tiles[i];
+				for (int y = t.y0; y < t.y1; ++y) {
+					for (int x = t.x0; x < t.x1; ++x) {
+						if (buffers) { write_features(x, y, pixel_albedo[p], pixel_normal[p]); }
+						write_pixel(output, x, y, pixel_colors[p++]);
+					}
+				}
+
+				// Increment number of pixels completed (for the progress bar)
+				n_pixels += (t.x1 - t.x0) * (t.y1 - t.y0);
+			}
+
+			tileIndex = batch_end;
 		}
 	}
 
@@ -61,6 +190,7 @@ namespace rtw {
 		auto h = std::tan(theta / 2);
 		auto viewport_height = 2 * h * focus_dist;
 		auto viewport_width = viewport_height * (double(image_width) / image_height);
+		pixel_angle = real(theta / image_height);
 
 		w = unit_vector(lookfrom - lookat);
         u = unit_vector(cross(vup, w));
@@ -82,53 +212,342 @@ namespace rtw {
 	}
 
 	// Ray Color
-	color Camera::ray_color(const ray& r, int depth, const Hittable& world) const {
-		// Base Case
+	color Camera::ray_color(const ray& r, int depth, const Scene& world, Sampler& sampler) const {
+		// Out of bounces
 		if (depth <= 0) { return color(0, 0, 0); }
 
+		// No t epsilon, scattered rays start off the surface already
+		// (see offset_ray_origin)
 		hit_record rec;
-		if (world.hit(r, Interval(0.001, INF), rec)) {
+		if (world.hit(r, Interval(0, INF), rec)) {
+			return hit_color(r, rec, depth, world, sampler);
+		}
+
+		return sky_color(world, r, 0);
+	}
+
+	// Hit Color
+	color Camera::hit_color(const ray& r, const hit_record& rec, int depth, const Scene& world, Sampler& sampler) const {
+		color radiance(0, 0, 0);
+		color throughput(1, 1, 1);
+		ray current = r;
+		hit_record current_rec = rec;
+
+		// Density the last bounce was scattered with, 0 when it didn't sample
+		// the lights (camera rays, mirrors, glass) so lights hit count fully
+		real bsdf_pdf = 0;
+
+		// Training, the guided bounces so far
+		guide_vertex vertices[MAX_GUIDE_VERTICES];
+		int n_vertices = 0;
+
+		for (int bounce = 1; ; ++bounce) {
+			const material& mat = world.materials[current_rec.mat];
+			radiance += throughput * emitted_light(world, current, current_rec, mat, bsdf_pdf);
+
+			const PathGuide* guided = bounce_guide(world, guide, current_rec);
+
+			// Next event estimation
+			bool direct = samples_lights(world, mat);
+			if (direct) {
+				light_sample reached;
+				bool training = train_guide && guided;
+				radiance += throughput * direct_light(world, current, current_rec, sampler, guided, bounce >= depth,
+					training ? &reached : nullptr);
+
+				// The light sample is light arriving here too, unweighted, so the
+				// guide learns where small lights are, not just what scattering found
+				if (training && reached.pdf > 0) {
+					const color& e = reached.emission;
+					real luminance = real(0.2126) * e.x() + real(0.7152) * e.y() + real(0.0722) * e.z();
+					guide->record(guide->region(current_rec.p), reached.direction, luminance / reached.pdf);
+				}
+			}
+
 			ray scattered;
 			color attenuation;
-			if (rec.mat->scatter(r, rec, attenuation, scattered)) {
-				// Color weighting and recursive call
-				return attenuation * ray_color(scattered, depth - 1, world);
+			real pdf = 0;
+			bool scatters = guided ? guided_scatter(*guided, current, current_rec, mat, attenuation, scattered, pdf, sampler)
+				: mat.scatter(current, current_rec, attenuation, scattered, sampler);
+			if (!scatters) {
+				// No material == void (or a light)
+				train(vertices, n_vertices, radiance);
+				return radiance;
+			}
+
+			if (direct && !guided) { pdf = mat.pdf(current, current_rec, unit_vector(scattered.direction())); }
+			bsdf_pdf = direct ? pdf : 0;
+
+			// Color weighting
+			throughput = throughput * attenuation;
+
+			if (train_guide && guided && n_vertices < MAX_GUIDE_VERTICES) {
+				vertices[n_vertices++] = { guide->region(current_rec.p), unit_vector(scattered.direction()), throughput, radiance, pdf };
+			}
+
+			// Out of bounces
+			if (bounce >= depth) {
+				train(vertices, n_vertices, radiance);
+				return radiance;
+			}
+
+			if (bounce >= roulette_depth && !russian_roulette(throughput, sampler.get_1d())) {
+				train(vertices, n_vertices, radiance);
+				return radiance;
+			}
+
+			// No t epsilon, scattered rays start off the surface already
+			current = scattered;
+			if (!world.hit(current, Interval(0, INF), current_rec)) {
+				radiance += throughput * sky_color(world, current, bsdf_pdf);
+				train(vertices, n_vertices, radiance);
+				return radiance;
 			}
-			// No material == void
-			return color(0, 0, 0);
 		}
+	}
 
-		// Background 'sky' fade
+	// Train Guide
+	void Camera::train(const guide_vertex* vertices, int n, const color& radiance) const {
+		for (int i = 0; i < n; ++i) {
+			const guide_vertex& v = vertices[i];
+
+			// Light found after the bounce, undoing the throughput up to it
+			color found = radiance - v.radiance;
+			color incident(0, 0, 0);
+			for (int c = 0; c < 3; ++c) {
+				if (v.throughput[c] > 0) { incident[c] = found[c] / v.throughput[c]; }
+			}
+
+			real luminance = real(0.2126) * incident.x() + real(0.7152) * incident.y() + real(0.0722) * incident.z();
+			guide->record(v.region, v.direction, luminance / v.pdf);
+		}
+	}
+
+	// Russian Roulette
+	bool Camera::russian_roulette(color& throughput, real u) {
+		real survival = std::fmax(throughput.x(), std::fmax(throughput.y(), throughput.z()));
+		if (survival >= 1) { return true; }
+		if (u >= survival) { return false; }
+
+		throughput /= survival;
+		return true;
+	}
+
+	/**
+	* Power Heuristic
+	* Veach's weight for a sample from one of two strategies
+	*
+	* @param f	Density of the strategy that took the sample
+	* @param g	Density of the other strategy for the same sample
+	*
+	* @return f^2 / (f^2 + g^2)
+	*/
+	static real power_heuristic(real f, real g) {
+		real f2 = f * f, g2 = g * g;
+		return f2 / (f2 + g2);
+	}
+
+	// Sky Color
+	color Camera::sky_color(const Scene& world, const ray& r, real bsdf_pdf, real footprint) {
 		vec3 unit_direction = unit_vector(r.direction());
+
+		const EnvironmentMap* env = world.environment();
+		if (env) {
+			color radiance = env->lookup(unit_direction, footprint);
+			if (bsdf_pdf > 0) {
+				radiance *= power_heuristic(bsdf_pdf, world.environment_pdf(unit_direction));
+			}
+			return radiance;
+		}
+
+		// Background 'sky' fade
 		auto a = 0.5 * (unit_direction.y() + 1.0);
 		return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
 	}
 
+	// Direct Light
+	color Camera::direct_light(const Scene& world, const ray& r, const hit_record& rec, Sampler& sampler,
+		const PathGuide* guide, bool last, light_sample* reached) {
+		if (reached) { reached->pdf = 0; }
+
+		real u_pick = sampler.get_1d();
+		vec3 u = sampler.get_2d();
+
+		// Lit from the normal's side only. Scattered rays leave from this same
+		// point (any direction on that side offsets the same), which keeps the
+		// light's density here and in emitted_light in agreement
+		point3 origin = offset_ray_origin(rec.p, rec.p_error, rec.normal, rec.normal);
+
+		light_sample ls;
+		if (!world.sample_light(origin, r.time(), u_pick, u, ls)) { return color(0, 0, 0); }
+
+		// Facing away, or a black light, no point tracing a shadow ray
+		const material& mat = world.materials[rec.mat];
+		color contribution = mat.evaluate(r, rec, ls.direction) * ls.emission;
+		if (std::fmax(contribution.x(), std::fmax(contribution.y(), contribution.z())) <= 0) { return color(0, 0, 0); }
+
+		// Shadow ray, any hit at all on the way means no light. Aimed at the
+		// point on the light from the offset origin, which can be a fair way
+		// off rec.p on big spheres (in floats), then stopped just short of it.
+		// The environment is behind everything, so anything along the way counts
+		ray shadow = ls.infinite ? ray(origin, ls.direction, r.time()) : ray(origin, ls.point - origin, r.time());
+		Interval span = ls.infinite ? Interval(0, INF) : Interval(0, 1 - SHADOW_EPSILON);
+		if (world.occluded(shadow, span)) { return color(0, 0, 0); }
+		if (reached) { *reached = ls; }
+
+		// Nothing scattered from here is traced, so nothing to weight against
+		if (last) { return contribution / ls.pdf; }
+
+		// Against whatever the bounce here scatters with
+		real scatter_pdf = mat.pdf(r, rec, ls.direction);
+		if (guide) {
+			std::uint32_t region = guide->region(rec.p);
+			real fraction = guide->trained(region) ? PathGuide::GUIDE_FRACTION : real(0);
+			scatter_pdf = fraction * guide->pdf(region, ls.direction) + (1 - fraction) * scatter_pdf;
+		}
+
+		real weight = power_heuristic(ls.pdf, scatter_pdf);
+		return contribution * (weight / ls.pdf);
+	}
+
+	// Emitted Light
+	color Camera::emitted_light(const Scene& world, const ray& r, const hit_record& rec, const material& mat, real bsdf_pdf) {
+		color emitted = mat.emitted(r, rec);
+		if (bsdf_pdf > 0 && rec.light >= 0) {
+			emitted *= power_heuristic(bsdf_pdf, world.light_pdf(r, rec));
+		}
+
+		return emitted;
+	}
+
+	// Samples Lights
+	bool Camera::samples_lights(const Scene& world, const material& mat) {
+		return world.has_lights() && !mat.is_specular();
+	}
+
+	// Guided Scatter
+	bool Camera::guided_scatter(const PathGuide& guide, const ray& r, const hit_record& rec, const material& mat,
+		color& attenuation, ray& scattered, real& pdf, Sampler& sampler) {
+
+		std::uint32_t region = guide.region(rec.p);
+		real fraction = guide.trained(region) ? PathGuide::GUIDE_FRACTION : real(0);
+
+		// Either way 2 more dimensions get used, the guide's or the material's
+		vec3 direction;
+		if (sampler.get_1d() < fraction) {
+			real guide_pdf;
+			direction = guide.sample(region, sampler.get_2d(), guide_pdf);
+			scattered = ray(offset_ray_origin(rec.p, rec.p_error, rec.normal, direction), direction, r.time());
+		}
+		else {
+			if (!mat.scatter(r, rec, attenuation, scattered, sampler)) { return false; }
+			direction = unit_vector(scattered.direction());
+		}
+
+		pdf = fraction * guide.pdf(region, direction) + (1 - fraction) * mat.pdf(r, rec, direction);
+		if (pdf <= 0) { return false; }
+
+		// Below the surface, the guide doesn't know which way the surface faces
+		color f = mat.evaluate(r, rec, direction);
+		if (std::fmax(f.x(), std::fmax(f.y(), f.z())) <= 0) { return false; }
+
+		attenuation = f / pdf;
+		return true;
+	}
+
+	// Bounce Guide
+	const PathGuide* Camera::bounce_guide(const Scene& world, const PathGuide* guide, const hit_record& rec) {
+		return (guide && world.materials.kind(rec.mat) == material_kind::lambertian) ? guide : nullptr;
+	}
+
+	// First Hit Features
+	void Camera::first_hit_features(const Scene& world, const ray& r, const hit_record* rec, color& albedo, vec3& normal) {
+		if (rec) {
+			albedo = world.materials[rec->mat].surface_albedo();
+			normal = rec->normal;
+			return;
+		}
+
+		color sky = sky_color(world, r, 0);
+		albedo = color(std::fmin(sky.x(), real(1)), std::fmin(sky.y(), real(1)), std::fmin(sky.z(), real(1)));
+		normal = vec3(0, 0, 0);
+	}
+
 	// Get Ray
-	ray Camera::get_ray(int x, int y) const {
-		auto offset = sample_square();
+	template <bool DEFOCUS, bool MOTION>
+	ray Camera::get_ray(int x, int y, int sample, Sampler& sampler) const {
+		sampler.start_pixel_sample(x, y, sample);
+
+		auto offset = sample_square(sampler.get_2d());
 		auto pixel_sample = pixel00_loc
 			+ ((x + offset.x()) * pixel_delta_u)
 			+ ((y + offset.y()) * pixel_delta_v);
 
-		auto ray_origin = (defocus_angle <= 0) ? center : defocus_disk_sample();
+		auto ray_origin = DEFOCUS ? defocus_disk_sample(sampler.get_2d()) : center;
 		auto ray_direction = pixel_sample - ray_origin;
-		auto ray_time = random_double();
+		auto ray_time = MOTION ? sampler.get_1d() : real(0);
 
 		return ray(ray_origin, ray_direction, ray_time);
 	}
 
 	// Sample Square
-	vec3 Camera::sample_square() const {
-		return vec3(random_double() - 0.5, random_double() - 0.5, 0);
+	vec3 Camera::sample_square(const vec3& u) const {
+		return vec3(u.x() - 0.5, u.y() - 0.5, 0);
 	}
 
 	// Defocus Disk Sample
-	point3 Camera::defocus_disk_sample() const {
-		auto p = random_in_unit_disk();
+	point3 Camera::defocus_disk_sample(const vec3& u) const {
+		auto p = sample_in_unit_disk(u);
 		return center + (p[0] * defocus_disk_u) + (p[1] * defocus_disk_v);
 	}
 
+	// Write Pixel
+	void Camera::write_pixel(unsigned char* output, int x, int y, color pixel_color) {
+		// Scale with weighting
+		pixel_color *= sample_scale;
+
+		if (buffers) {
+			float* c = &buffers->color[3 * (size_t(y) * image_width + x)];
+			c[0] = float(pixel_color.x());
+			c[1] = float(pixel_color.y());
+			c[2] = float(pixel_color.z());
+		}
+
+		write_color(output, image_width, x, y, pixel_color);
+	}
+
+	// Write Features
+	void Camera::write_features(int x, int y, color albedo, vec3 normal) {
+		albedo *= sample_scale;
+		normal *= sample_scale;
+
+		float* a = &buffers->albedo[3 * (size_t(y) * image_width + x)];
+		float* n = &buffers->normal[3 * (size_t(y) * image_width + x)];
+		for (int c = 0; c < 3; ++c) {
+			a[c] = float(albedo[c]);
+			n[c] = float(normal[c]);
+		}
+	}
+
+	// Write Color
+	void Camera::write_color(unsigned char* output, int width, int x, int y, color c) {
+		// Gamma correction
+		auto r = c.x();
+		auto g = c.y();
+		auto b = c.z();
+		r = linear_to_gamma(r);
+		g = linear_to_gamma(g);
+		b = linear_to_gamma(b);
+
+		// 0 - 255 Clamping * writing to output
+		// This is where color.hpp's write color would
+		// normally be used
+		static const Interval intensity(0.000, 0.999);
+		output[3 * (y * width + x) + 0] = int(intensity.clamp(r) * 256);
+		output[3 * (y * width + x) + 1] = int(intensity.clamp(g) * 256);
+		output[3 * (y * width + x) + 2] = int(intensity.clamp(b) * 256);
+	}
+
 	// Linear to Gamma
 	double Camera::linear_to_gamma(double linear_component) {
 		if (linear_component > 0) {
@@ -0,0 +1,99 @@
+// cpu.cpp - Implementation of the host CPU feature detection
+// Ethan Rudy
+
+#include "../../include/rtw/cpu.h"
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace rtw {
+
+	/**
+	* Detect
+	* GCC/Clang already check OS support in __builtin_cpu_supports,
+	* with MSVC we read cpuid and xgetbv ourselves
+	*/
+	static cpu_features detect() {
+		cpu_features f;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		f.sse2 = __builtin_cpu_supports("sse2");
+		f.sse41 = __builtin_cpu_supports("sse4.1");
+		f.avx = __builtin_cpu_supports("avx");
+		f.avx2 = __builtin_cpu_supports("avx2");
+		f.fma = __builtin_cpu_supports("fma");
+		f.avx512f = __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int info[4];
+		__cpuid(info, 0);
+		int max_leaf = info[0];
+
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		f.sse2 = (info[3] & (1 << 26)) != 0;
+		f.sse41 = (info[2] & (1 << 19)) != 0;
+		f.fma = (info[2] & (1 << 12)) != 0;
+		bool avx_bit = (info[2] & (1 << 28)) != 0;
+
+		// OS has to save the ymm (bits 1-2) and zmm (bits 5-7) state
+		unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+		bool ymm_saved = (xcr0 & 0x6) == 0x6;
+		bool zmm_saved = (xcr0 & 0xe6) == 0xe6;
+
+		f.avx = avx_bit && ymm_saved;
+		f.fma = f.fma && ymm_saved;
+
+		if (max_leaf >= 7) {
+			__cpuidex(info, 7, 0);
+			f.avx2 = f.avx && (info[1] & (1 << 5)) != 0;
+			f.avx512f = zmm_saved && (info[1] & (1 << 16)) != 0;
+		}
+#endif
+
+		return f;
+	}
+
+	// Host CPU
+	const cpu_features& host_cpu() {
+		static const cpu_features features = detect();
+		return features;
+	}
+
+	// SIMD Level
+	simd_level host_simd_level() {
+		const cpu_features& f = host_cpu();
+
+		simd_level level = simd_level::scalar;
+		if (f.sse2) { level = simd_level::sse2; }
+		if (f.avx2 && f.fma) { level = simd_level::avx2; }
+		if (f.avx512f && f.avx2 && f.fma) { level = simd_level::avx512; }
+
+		// Cap from the environment, never raised past what the CPU has
+		if (const char* cap = std::getenv("RTW_SIMD")) {
+			for (simd_level l : { simd_level::scalar, simd_level::sse2, simd_level::avx2, simd_level::avx512 }) {
+				if (std::strcmp(cap, simd_level_name(l)) == 0 && l < level) {
+					level = l;
+				}
+			}
+		}
+
+		return level;
+	}
+
+	// SIMD Level Name
+	const char* simd_level_name(simd_level level) {
+		switch (level) {
+		case simd_level::sse2: return "sse2";
+		case simd_level::avx2: return "avx2";
+		case simd_level::avx512: return "avx512";
+		default: return "scalar";
+		}
+	}
+
+}
@@ -0,0 +1,205 @@
+// denoiser.cpp - Implementation of the Denoiser class
+// Ethan Rudy
+
+#include "../../include/rtw/denoiser.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef RTW_X86
+#include <immintrin.h>
+#endif
+
+#include "../../include/rtw/denoiser_simd.h"
+
+namespace rtw {
+
+	// Resize
+	void render_buffers::resize(int w, int h) {
+		width = w;
+		height = h;
+		color.assign(3 * size_t(w) * h, 0);
+		albedo.assign(3 * size_t(w) * h, 0);
+		normal.assign(3 * size_t(w) * h, 0);
+	}
+
+
+
+	namespace {
+
+		// Scalar, 1 float
+		struct simd_scalar_float {
+			using reg = float;
+			static const int WIDTH = 1;
+
+			static reg set1(float x) { return x; }
+			static reg load(const float* p) { return *p; }
+			static void store(float* p, reg a) { *p = a; }
+			static reg add(reg a, reg b) { return a + b; }
+			static reg sub(reg a, reg b) { return a - b; }
+			static reg mul(reg a, reg b) { return a * b; }
+			static reg div(reg a, reg b) { return a / b; }
+			static reg sqrt(reg a) { return std::sqrt(a); }
+			static reg min(reg a, reg b) { return std::min(a, b); }
+			static reg max(reg a, reg b) { return std::max(a, b); }
+		};
+
+#ifdef RTW_X86
+		// SSE2, 4 floats
+		struct simd_sse2_float {
+			using reg = __m128;
+			static const int WIDTH = 4;
+
+			static reg set1(float x) { return _mm_set1_ps(x); }
+			static reg load(const float* p) { return _mm_loadu_ps(p); }
+			static void store(float* p, reg a) { _mm_storeu_ps(p, a); }
+			static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+			static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+			static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+			static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+			static reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+			static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+			static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+		};
+#endif
+	}
+
+	// Denoise Rows (Scalar)
+	void denoise_rows_scalar(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p) {
+		denoise_rows_simd<simd_scalar_float>(in, out, y0, y1, p);
+	}
+
+#ifdef RTW_X86
+	// Denoise Rows (SSE2)
+	void denoise_rows_sse2(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p) {
+		denoise_rows_simd<simd_sse2_float>(in, out, y0, y1, p);
+	}
+#endif
+
+
+
+	// Row filter signature, all of the above share it
+	using denoise_rows_fn = void (*)(const denoise_planes&, denoise_planes&, int, int, const denoise_params&);
+
+	/**
+	* Select Rows
+	* No AVX-512 version, the filter waits on memory more than math,
+	* so AVX-512 machines get the AVX2 one
+	*
+	* @return Widest version of the row filter the host CPU can run
+	*/
+	static denoise_rows_fn select_rows() {
+		switch (host_simd_level()) {
+#ifdef RTW_X86
+		case simd_level::avx512:
+		case simd_level::avx2: return denoise_rows_avx2;
+		case simd_level::sse2: return denoise_rows_sse2;
+#endif
+		default: return denoise_rows_scalar;
+		}
+	}
+
+	// Denoise Rows
+	void denoise_rows(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p) {
+		static const denoise_rows_fn rows = select_rows();
+		rows(in, out, y0, y1, p);
+	}
+
+
+
+	// Split
+	template <typename F>
+	void Denoiser::split_rows(int height, int n_threads, F rows) {
+		n_threads = std::max(1, std::min(n_threads, height));
+		if (n_threads == 1) {
+			rows(0, height);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < n_threads; ++t) {
+			int y0 = int(long(height) * t / n_threads);
+			int y1 = int(long(height) * (t + 1) / n_threads);
+			threads.push_back(std::thread(rows, y0, y1));
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+	}
+
+	// Estimate Variance
+	void Denoiser::estimate_variance(denoise_planes& planes, int y0, int y1) {
+		const int width = planes.width, height = planes.height;
+
+		for (int y = y0; y < y1; ++y) {
+			for (int x = 0; x < width; ++x) {
+				float sum = 0, sum2 = 0;
+				int n = 0;
+
+				for (int j = std::max(0, y - 2); j <= std::min(y + 2, height - 1); ++j) {
+					for (int i = std::max(0, x - 2); i <= std::min(x + 2, width - 1); ++i) {
+						size_t q = size_t(j) * width + i;
+						float l = 0.2126f * planes.r[q] + 0.7152f * planes.g[q] + 0.0722f * planes.b[q];
+						sum += l;
+						sum2 += l * l;
+						++n;
+					}
+				}
+
+				float mean = sum / n;
+				planes.var[size_t(y) * width + x] = std::max(0.0f, sum2 / n - mean * mean);
+			}
+		}
+	}
+
+	// Denoise
+	void Denoiser::denoise(const render_buffers& buffers, std::vector<float>& output, int n_threads) const {
+		const int width = buffers.width, height = buffers.height;
+		const size_t n = size_t(width) * height;
+		output = buffers.color;
+		if (n == 0 || iterations <= 0) { return; }
+
+		// Interleaved buffers to planes, anything that isn't finite is dropped
+		denoise_planes a;
+		a.width = width;
+		a.height = height;
+		std::vector<float>* planes[9] = { &a.r, &a.g, &a.b, &a.ar, &a.ag, &a.ab, &a.nx, &a.ny, &a.nz };
+		const std::vector<float>* sources[3] = { &buffers.color, &buffers.albedo, &buffers.normal };
+		for (int c = 0; c < 9; ++c) {
+			std::vector<float>& plane = *planes[c];
+			const std::vector<float>& source = *sources[c / 3];
+			plane.resize(n);
+			for (size_t i = 0; i < n; ++i) {
+				float v = source[3 * i + c % 3];
+				plane[i] = std::isfinite(v) ? v : 0.0f;
+			}
+		}
+		a.var.resize(n);
+
+		split_rows(height, n_threads, [&a](int y0, int y1) { estimate_variance(a, y0, y1); });
+
+		// Filtered into, features copied along since they never change
+		denoise_planes b = a;
+
+		denoise_params params;
+		params.sigma_luminance = sigma_luminance;
+		params.inv_sigma_normal2 = 1.0f / (sigma_normal * sigma_normal);
+		params.inv_sigma_albedo2 = 1.0f / (sigma_albedo * sigma_albedo);
+
+		// Ping pong between the two, the taps spread out each time
+		denoise_planes* in = &a;
+		denoise_planes* out = &b;
+		for (int i = 0; i < iterations; ++i) {
+			params.step = 1 << i;
+			split_rows(height, n_threads, [in, out, &params](int y0, int y1) { denoise_rows(*in, *out, y0, y1, params); });
+			std::swap(in, out);
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			output[3 * i + 0] = in->r[i];
+			output[3 * i + 1] = in->g[i];
+			output[3 * i + 2] = in->b[i];
+		}
+	}
+
+}
@@ -0,0 +1,53 @@
+// denoiser_avx2.cpp - AVX2 version of the a-trous filter rows
+// Ethan Rudy
+
+#include "../../include/rtw/denoiser.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef RTW_X86
+#include <immintrin.h>
+
+// Everything below is built for AVX2 + FMA (Haswell, Zen), only ever
+// called once host_simd_level() says the CPU has them
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#include "../../include/rtw/denoiser_simd.h"
+
+namespace rtw {
+
+	namespace {
+
+		// AVX, 8 floats
+		struct simd_avx2_float {
+			using reg = __m256;
+			static const int WIDTH = 8;
+
+			static reg set1(float x) { return _mm256_set1_ps(x); }
+			static reg load(const float* p) { return _mm256_loadu_ps(p); }
+			static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+			static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+			static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+			static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+			static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+			static reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+			static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+			static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+		};
+	}
+
+	// Denoise Rows (AVX2)
+	void denoise_rows_avx2(const denoise_planes& in, denoise_planes& out, int y0, int y1, const denoise_params& p) {
+		denoise_rows_simd<simd_avx2_float>(in, out, y0, y1, p);
+	}
+
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#endif
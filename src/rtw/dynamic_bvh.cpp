@@ -0,0 +1,321 @@
+// dynamic_bvh.cpp - Implementation of the dynamic_bvh class
+// Ethan Rudy
+
+#include "../../include/rtw/dynamic_bvh.h"
+
+namespace rtw {
+
+	// Margin Constructor
+	dynamic_bvh::dynamic_bvh(real margin)
+		: root(NULL_NODE), free_list(NULL_NODE), n_objects(0), margin(margin) {}
+
+	// List Constructor
+	dynamic_bvh::dynamic_bvh(const HittableList& list, real margin) : dynamic_bvh(margin) {
+		nodes.reserve(2 * list.objects.size());
+		for (const auto& object : list.objects) {
+			insert(object);
+		}
+	}
+
+	// Insert
+	int dynamic_bvh::insert(std::shared_ptr<Hittable> object) {
+		int leaf = allocate_node();
+		nodes[leaf].box = fat_box(*object);
+		nodes[leaf].object = object;
+		nodes[leaf].height = 0;
+
+		insert_leaf(leaf);
+		++n_objects;
+
+		return leaf;
+	}
+
+	// Remove
+	void dynamic_bvh::remove(int id) {
+		remove_leaf(id);
+		free_node(id);
+		--n_objects;
+	}
+
+	// Move
+	bool dynamic_bvh::move(int id) {
+		// Still fits in the fat box, nothing to do
+		if (nodes[id].box.contains(nodes[id].object->bounding_box())) { return false; }
+
+		remove_leaf(id);
+		nodes[id].box = fat_box(*nodes[id].object);
+		insert_leaf(id);
+
+		return true;
+	}
+
+	// Move (replace)
+	bool dynamic_bvh::move(int id, std::shared_ptr<Hittable> object) {
+		nodes[id].object = object;
+		return move(id);
+	}
+
+	// Number of objects
+	size_t dynamic_bvh::size() const { return n_objects; }
+
+	// Height
+	int dynamic_bvh::height() const {
+		return root == NULL_NODE ? 0 : nodes[root].height;
+	}
+
+	// Hit
+	// Only the closest hit's record gets built
+	bool dynamic_bvh::hit(const ray& r, Interval ray_t, hit_record& rec) const {
+		return deferred_hit(r, ray_t, rec);
+	}
+
+	// Intersect
+	bool dynamic_bvh::intersect(const ray& r, Interval ray_t, hit_info& info) const {
+		if (root == NULL_NODE) { return false; }
+
+		// The tree is kept balanced, so its height stays way below this
+		int stack[128];
+		int stack_size = 0;
+		stack[stack_size++] = root;
+
+		bool hit_anything = false;
+		auto closest_so_far = ray_t.max;
+
+		while (stack_size > 0) {
+			const node& n = nodes[stack[--stack_size]];
+
+			if (!n.box.hit(r, Interval(ray_t.min, closest_so_far))) { continue; }
+
+			if (n.is_leaf()) {
+				if (n.object->intersect(r, Interval(ray_t.min, closest_so_far), info)) {
+					hit_anything = true;
+					closest_so_far = info.t;
+				}
+			}
+			else {
+				stack[stack_size++] = n.right;
+				stack[stack_size++] = n.left;
+			}
+		}
+
+		return hit_anything;
+	}
+
+	// Occluded
+	bool dynamic_bvh::occluded(const ray& r, Interval ray_t) const {
+		if (root == NULL_NODE) { return false; }
+
+		int stack[128];
+		int stack_size = 0;
+		stack[stack_size++] = root;
+
+		while (stack_size > 0) {
+			const node& n = nodes[stack[--stack_size]];
+
+			if (!n.box.hit(r, ray_t)) { continue; }
+
+			if (n.is_leaf()) {
+				if (n.object->occluded(r, ray_t)) { return true; }
+			}
+			else {
+				stack[stack_size++] = n.right;
+				stack[stack_size++] = n.left;
+			}
+		}
+
+		return false;
+	}
+
+	// Bounding Box
+	aabb dynamic_bvh::bounding_box() const {
+		return root == NULL_NODE ? aabb::empty : nodes[root].box;
+	}
+
+
+
+	// Allocate Node
+	int dynamic_bvh::allocate_node() {
+		if (free_list == NULL_NODE) {
+			nodes.push_back(node());
+			return int(nodes.size() - 1);
+		}
+
+		int id = free_list;
+		free_list = nodes[id].parent;
+		nodes[id] = node();
+		return id;
+	}
+
+	// Free Node
+	void dynamic_bvh::free_node(int id) {
+		nodes[id].object.reset();
+		nodes[id].left = nodes[id].right = NULL_NODE;
+		nodes[id].height = -1;
+		nodes[id].parent = free_list;
+		free_list = id;
+	}
+
+	// Fat Box
+	aabb dynamic_bvh::fat_box(const Hittable& object) const {
+		aabb box = object.bounding_box();
+		return aabb(box.x.expand(2 * margin), box.y.expand(2 * margin), box.z.expand(2 * margin));
+	}
+
+	// Insert Leaf
+	void dynamic_bvh::insert_leaf(int leaf) {
+		if (root == NULL_NODE) {
+			root = leaf;
+			nodes[root].parent = NULL_NODE;
+			return;
+		}
+
+		// Walk down picking whichever side is cheaper, stopping once
+		// making a new parent right here is cheaper than going further
+		aabb leaf_box = nodes[leaf].box;
+		int index = root;
+		while (!nodes[index].is_leaf()) {
+			const node& n = nodes[index];
+
+			double area = n.box.surface_area();
+			double combined_area = aabb(n.box, leaf_box).surface_area();
+
+			// Cost of a new parent for this node and the leaf
+			double cost = 2 * combined_area;
+
+			// Minimum cost of pushing the leaf further down
+			double inheritance_cost = 2 * (combined_area - area);
+
+			auto child_cost = [&](int child) {
+				const node& c = nodes[child];
+				double grown = aabb(c.box, leaf_box).surface_area();
+				return c.is_leaf() ? grown + inheritance_cost
+					: grown - c.box.surface_area() + inheritance_cost;
+			};
+
+			double cost_left = child_cost(n.left);
+			double cost_right = child_cost(n.right);
+
+			if (cost < cost_left && cost < cost_right) { break; }
+
+			index = cost_left < cost_right ? n.left : n.right;
+		}
+
+		int sibling = index;
+
+		// New parent for the sibling and leaf
+		int old_parent = nodes[sibling].parent;
+		int new_parent = allocate_node();
+		nodes[new_parent].parent = old_parent;
+		nodes[new_parent].left = sibling;
+		nodes[new_parent].right = leaf;
+		nodes[new_parent].box = aabb(leaf_box, nodes[sibling].box);
+		nodes[new_parent].height = nodes[sibling].height + 1;
+
+		if (old_parent != NULL_NODE) {
+			if (nodes[old_parent].left == sibling) { nodes[old_parent].left = new_parent; }
+			else { nodes[old_parent].right = new_parent; }
+		}
+		else {
+			root = new_parent;
+		}
+
+		nodes[sibling].parent = new_parent;
+		nodes[leaf].parent = new_parent;
+
+		// Fix up boxes and balance on the way back up
+		refit_upwards(nodes[leaf].parent);
+	}
+
+	// Remove Leaf
+	void dynamic_bvh::remove_leaf(int leaf) {
+		if (leaf == root) {
+			root = NULL_NODE;
+			return;
+		}
+
+		int parent = nodes[leaf].parent;
+		int grand_parent = nodes[parent].parent;
+		int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+		if (grand_parent != NULL_NODE) {
+			// Sibling takes the parent's place
+			if (nodes[grand_parent].left == parent) { nodes[grand_parent].left = sibling; }
+			else { nodes[grand_parent].right = sibling; }
+			nodes[sibling].parent = grand_parent;
+			free_node(parent);
+
+			refit_upwards(grand_parent);
+		}
+		else {
+			root = sibling;
+			nodes[sibling].parent = NULL_NODE;
+			free_node(parent);
+		}
+	}
+
+	// Refit Upwards
+	void dynamic_bvh::refit_upwards(int index) {
+		while (index != NULL_NODE) {
+			index = balance(index);
+			refit(index);
+			index = nodes[index].parent;
+		}
+	}
+
+	// Balance
+	int dynamic_bvh::balance(int a) {
+		if (nodes[a].is_leaf() || nodes[a].height < 2) { return a; }
+
+		int b = nodes[a].left;
+		int c = nodes[a].right;
+		int lopsided = nodes[c].height - nodes[b].height;
+
+		// Nothing to do
+		if (lopsided >= -1 && lopsided <= 1) { return a; }
+
+		// Child to rotate up, the sibling it leaves behind,
+		// and which side of 'a' it used to be on
+		bool rotate_right = lopsided > 1;
+		int up = rotate_right ? c : b;
+		int f = nodes[up].left;
+		int g = nodes[up].right;
+
+		// Swap 'a' and 'up'
+		nodes[up].left = a;
+		nodes[up].parent = nodes[a].parent;
+		nodes[a].parent = up;
+
+		if (nodes[up].parent != NULL_NODE) {
+			int p = nodes[up].parent;
+			if (nodes[p].left == a) { nodes[p].left = up; }
+			else { nodes[p].right = up; }
+		}
+		else {
+			root = up;
+		}
+
+		// Taller grandchild stays with 'up', shorter one moves down to 'a'
+		int keep = nodes[f].height > nodes[g].height ? f : g;
+		int give = keep == f ? g : f;
+
+		nodes[up].right = keep;
+		if (rotate_right) { nodes[a].right = give; }
+		else { nodes[a].left = give; }
+		nodes[give].parent = a;
+
+		refit(a);
+		refit(up);
+
+		return up;
+	}
+
+	// Refit
+	void dynamic_bvh::refit(int index) {
+		node& n = nodes[index];
+		if (n.is_leaf()) { return; }
+
+		n.box = aabb(nodes[n.left].box, nodes[n.right].box);
+		n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+	}
+
+}
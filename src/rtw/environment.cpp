@@ -0,0 +1,267 @@
+// environment.cpp - Implementation of the EnvironmentMap class
+// Ethan Rudy
+
+#include "../../include/rtw/environment.h"
+#include <algorithm>
+
+// Implementation is compiled with the OpenGL textures (texture.cpp)
+#include "stb_image.h"
+
+namespace rtw {
+
+	// Constructor
+	EnvironmentMap::EnvironmentMap(const char* path, bool mips) : total_power(0) {
+		// Top row first, the OpenGL textures flip theirs
+		stbi_set_flip_vertically_on_load(false);
+
+		int width, height, channels;
+		float* data = stbi_loadf(path, &width, &height, &channels, 3);
+		if (data) {
+			levels.push_back({ width, height, std::vector<float>(data, data + 3 * size_t(width) * height) });
+			build(mips);
+		}
+		else {
+			std::cout << "ERROR::ENVIRONMENT::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+		}
+
+		// Free memory
+		stbi_image_free(data);
+	}
+
+	// Pixel Constructor
+	EnvironmentMap::EnvironmentMap(int width, int height, const float* rgb, bool mips) : total_power(0) {
+		if (width <= 0 || height <= 0) { return; }
+
+		levels.push_back({ width, height, std::vector<float>(rgb, rgb + 3 * size_t(width) * height) });
+		build(mips);
+	}
+
+	// Valid
+	bool EnvironmentMap::valid() const { return !levels.empty(); }
+
+	/**
+	* Direction To UV
+	*
+	* @param d	Unit direction
+	* @param u	Around, [0, 1) starting at +x (ref)
+	* @param v	Down, [0, 1] starting at +y (ref)
+	*/
+	static void direction_to_uv(const vec3& d, real& u, real& v) {
+		real phi = std::atan2(d.z(), d.x());
+		if (phi < 0) { phi += real(2 * PI); }
+
+		u = std::min(phi / real(2 * PI), real(1) - std::numeric_limits<real>::epsilon());
+		v = std::acos(std::fmax(real(-1), std::fmin(real(1), d.y()))) / real(PI);
+	}
+
+	/**
+	* Luminance
+	*
+	* @param c	Linear color
+	*
+	* @return Rec. 709 luminance
+	*/
+	static real luminance(const color& c) {
+		return real(0.2126) * c.x() + real(0.7152) * c.y() + real(0.0722) * c.z();
+	}
+
+	/**
+	* Sample CDF
+	* Inverts a piecewise constant distribution
+	*
+	* @param cdf	n + 1 entries, 0 to 1
+	* @param n		Number of pieces
+	* @param u		Uniform sample in [0, 1)
+	* @param pdf	Density of the result over [0, 1) (ref)
+	*
+	* @return Continuous position in [0, 1)
+	*/
+	static real sample_cdf(const float* cdf, int n, real u, real& pdf) {
+		// Piece i with cdf[i] <= u < cdf[i + 1], never an empty one
+		int i = int(std::upper_bound(cdf, cdf + n + 1, float(u)) - cdf) - 1;
+		i = std::max(0, std::min(i, n - 1));
+
+		real width = real(cdf[i + 1]) - real(cdf[i]);
+		pdf = width * n;
+
+		real offset = width > 0 ? (u - real(cdf[i])) / width : real(0);
+		offset = std::fmax(real(0), std::fmin(offset, real(1) - std::numeric_limits<real>::epsilon()));
+		return (i + offset) / n;
+	}
+
+	// Lookup
+	color EnvironmentMap::lookup(const vec3& direction, real footprint) const {
+		if (levels.empty()) { return color(0, 0, 0); }
+
+		real u, v;
+		direction_to_uv(direction, u, v);
+
+		// A texel is pi / height tall, level l's are 2^l times that
+		real level = footprint > 0 ? std::log2(footprint * levels[0].height / real(PI)) : real(0);
+		if (levels.size() == 1 || level <= 0) { return bilinear(levels[0], u, v); }
+
+		int last = int(levels.size()) - 1;
+		if (level >= last) { return bilinear(levels[last], u, v); }
+
+		int l0 = int(level);
+		real t = level - l0;
+		return (1 - t) * bilinear(levels[l0], u, v) + t * bilinear(levels[l0 + 1], u, v);
+	}
+
+	// Sample
+	color EnvironmentMap::sample(const vec3& u, vec3& direction, real& pdf) const {
+		pdf = 0;
+		if (levels.empty() || total_power <= 0) { return color(0, 0, 0); }
+
+		const mip_level& map = levels[0];
+
+		// Row, then where along the row
+		real pdf_v, pdf_u;
+		real v = sample_cdf(marginal.data(), map.height, u.y(), pdf_v);
+		int row = std::min(int(v * map.height), map.height - 1);
+		real s = sample_cdf(&conditional[size_t(row) * (map.width + 1)], map.width, u.x(), pdf_u);
+
+		real theta = v * real(PI), phi = s * real(2 * PI);
+		real sin_theta = std::sin(theta);
+		if (sin_theta <= 0) { return color(0, 0, 0); }
+
+		direction = vec3(sin_theta * std::cos(phi), std::cos(theta), sin_theta * std::sin(phi));
+
+		// Image area to solid angle
+		pdf = pdf_v * pdf_u / (real(2 * PI * PI) * sin_theta);
+		return lookup(direction);
+	}
+
+	// PDF
+	real EnvironmentMap::pdf(const vec3& direction) const {
+		if (levels.empty() || total_power <= 0) { return 0; }
+
+		const mip_level& map = levels[0];
+
+		real u, v;
+		direction_to_uv(direction, u, v);
+
+		real sin_theta = std::sin(v * real(PI));
+		if (sin_theta <= 0) { return 0; }
+
+		// Same pieces sample picks from
+		int row = std::min(int(v * map.height), map.height - 1);
+		int column = std::min(int(u * map.width), map.width - 1);
+		const float* cdf = &conditional[size_t(row) * (map.width + 1)];
+
+		real pdf_v = (real(marginal[row + 1]) - real(marginal[row])) * map.height;
+		real pdf_u = (real(cdf[column + 1]) - real(cdf[column])) * map.width;
+		return pdf_v * pdf_u / (real(2 * PI * PI) * sin_theta);
+	}
+
+	// Power
+	real EnvironmentMap::power() const { return total_power; }
+
+	// Build
+	void EnvironmentMap::build(bool mips) {
+		// Each level averages 2x2 texels of the last, odd edges repeat
+		while (mips && (levels.back().width > 1 || levels.back().height > 1)) {
+			const mip_level& fine = levels.back();
+			mip_level coarse = { std::max(1, fine.width / 2), std::max(1, fine.height / 2), {} };
+			coarse.texels.resize(3 * size_t(coarse.width) * coarse.height);
+
+			for (int y = 0; y < coarse.height; ++y) {
+				int y0 = std::min(2 * y, fine.height - 1), y1 = std::min(2 * y + 1, fine.height - 1);
+				for (int x = 0; x < coarse.width; ++x) {
+					int x0 = std::min(2 * x, fine.width - 1), x1 = std::min(2 * x + 1, fine.width - 1);
+					for (int c = 0; c < 3; ++c) {
+						float sum = fine.texels[3 * (size_t(y0) * fine.width + x0) + c] + fine.texels[3 * (size_t(y0) * fine.width + x1) + c]
+							+ fine.texels[3 * (size_t(y1) * fine.width + x0) + c] + fine.texels[3 * (size_t(y1) * fine.width + x1) + c];
+						coarse.texels[3 * (size_t(y) * coarse.width + x) + c] = 0.25f * sum;
+					}
+				}
+			}
+
+			levels.push_back(std::move(coarse));
+		}
+
+		build_distribution();
+	}
+
+	// Build Distribution
+	void EnvironmentMap::build_distribution() {
+		const mip_level& map = levels[0];
+		int width = map.width, height = map.height;
+
+		marginal.assign(size_t(height) + 1, 0);
+		conditional.assign(size_t(height) * (width + 1), 0);
+
+		// Texel luminance, skipping any that aren't finite or are negative
+		std::vector<double> lum(size_t(width) * height);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				double l = luminance(texel(map, x, y));
+				lum[size_t(y) * width + x] = std::isfinite(l) && l > 0 ? l : 0;
+			}
+		}
+
+		// Lookups blend neighbouring texels, so each texel is weighted by the
+		// brightest one around it. Anywhere the lookup isn't black can be picked
+		std::vector<double> row_sum(height);
+		double power = 0, total = 0;
+		for (int y = 0; y < height; ++y) {
+			double sin_theta = std::sin(PI * (y + 0.5) / height);
+			float* cdf = &conditional[size_t(y) * (width + 1)];
+
+			double sum = 0;
+			for (int x = 0; x < width; ++x) {
+				double w = 0;
+				for (int dy = -1; dy <= 1; ++dy) {
+					int ny = std::max(0, std::min(y + dy, height - 1));
+					for (int dx = -1; dx <= 1; ++dx) {
+						int nx = ((x + dx) % width + width) % width;
+						w = std::max(w, lum[size_t(ny) * width + nx]);
+					}
+				}
+
+				sum += w;
+				cdf[x + 1] = float(sum);
+				power += lum[size_t(y) * width + x] * sin_theta;
+			}
+
+			// Normalize the row, a black row is sampled evenly (it never gets picked anyway)
+			for (int x = 1; x <= width; ++x) { cdf[x] = sum > 0 ? float(cdf[x] / sum) : float(x) / width; }
+			cdf[width] = 1;
+
+			row_sum[y] = sum * sin_theta;
+			total += row_sum[y];
+		}
+
+		double running = 0;
+		for (int y = 0; y < height; ++y) {
+			running += row_sum[y];
+			marginal[y + 1] = total > 0 ? float(running / total) : float(y + 1) / height;
+		}
+		marginal[height] = 1;
+
+		// Each texel covers (2 pi / width) * (pi / height) of the image, times sin theta on the sphere
+		total_power = total > 0 ? real(power * 2 * PI * PI / (double(width) * height)) : real(0);
+	}
+
+	// Texel
+	color EnvironmentMap::texel(const mip_level& level, int x, int y) const {
+		x = ((x % level.width) + level.width) % level.width;
+		y = std::max(0, std::min(y, level.height - 1));
+
+		const float* t = &level.texels[3 * (size_t(y) * level.width + x)];
+		return color(t[0], t[1], t[2]);
+	}
+
+	// Bilinear
+	color EnvironmentMap::bilinear(const mip_level& level, real u, real v) const {
+		// Texel centers sit at half coordinates
+		real x = u * level.width - real(0.5);
+		real y = v * level.height - real(0.5);
+		int x0 = int(std::floor(x)), y0 = int(std::floor(y));
+		real fx = x - x0, fy = y - y0;
+
+		return (1 - fy) * ((1 - fx) * texel(level, x0, y0) + fx * texel(level, x0 + 1, y0))
+			+ fy * ((1 - fx) * texel(level, x0, y0 + 1) + fx * texel(level, x0 + 1, y0 + 1));
+	}
+
+}
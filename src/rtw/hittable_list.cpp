@@ -21,25 +21,39 @@ namespace rtw {
     }
 
     // Hit
+    // Only the closest hit's record gets built
     bool HittableList::hit(const ray& r, Interval ray_t, hit_record& rec) const {
-        hit_record temp_rec;
+        return deferred_hit(r, ray_t, rec);
+    }
+
+    // Intersect
+    bool HittableList::intersect(const ray& r, Interval ray_t, hit_info& info) const {
         bool hit_anything = false;
         auto closest_so_far = ray_t.max;
 
         // Loop over Hittables
+        // Objects only write info on a (closer) hit, so no temporary to copy
         for (const auto& object : objects) {
             
             // Check if anything was hit
-            if (object->hit(r, Interval(ray_t.min, closest_so_far), temp_rec)) {
+            if (object->intersect(r, Interval(ray_t.min, closest_so_far), info)) {
                 hit_anything = true;
-                closest_so_far = temp_rec.t;
-                rec = temp_rec;
+                closest_so_far = info.t;
             }
         }
 
         return hit_anything;
     }
 
+    // Occluded
+    bool HittableList::occluded(const ray& r, Interval ray_t) const {
+        for (const auto& object : objects) {
+            if (object->occluded(r, ray_t)) { return true; }
+        }
+
+        return false;
+    }
+
     // Bounding Box
     aabb HittableList::bounding_box() const { return bbox; }
 }
\ No newline at end of file
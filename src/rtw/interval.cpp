@@ -6,34 +6,41 @@
 namespace rtw {
 
 	// Default Constructor
-	Interval::Interval() : min(+INF), max(-INF) {}
+	template <typename T>
+	basic_interval<T>::basic_interval() : min(T(+INF)), max(T(-INF)) {}
 
 	// Min/Max Constructor
-	Interval::Interval(double min, double max) : min(min), max(max) {}
+	template <typename T>
+	basic_interval<T>::basic_interval(T min, T max) : min(min), max(max) {}
 
 	// Union Constructor
-	Interval::Interval(const Interval& a, const Interval& b) {
+	template <typename T>
+	basic_interval<T>::basic_interval(const basic_interval& a, const basic_interval& b) {
 		min = a.min <= b.min ? a.min : b.min;
-		max = a.max >= -b.max ? a.max : b.max;
+		max = a.max >= b.max ? a.max : b.max;
 	}
 
 	// Size / Span
-	double Interval::size() const {
+	template <typename T>
+	T basic_interval<T>::size() const {
 		return max - min;
 	}
 
 	// Contains Number 'x'
-	double Interval::contains(double x) const {
+	template <typename T>
+	bool basic_interval<T>::contains(T x) const {
 		return min <= x && x <= max;
 	}
 
 	// Surrounds Number 'x'
-	bool Interval::surrounds(double x) const {
+	template <typename T>
+	bool basic_interval<T>::surrounds(T x) const {
 		return min < x && x < max;
 	}
 
 	// Clamp 'x'
-	double Interval::clamp(double x) const {
+	template <typename T>
+	T basic_interval<T>::clamp(T x) const {
 		if (x < min) { return min; }
 		if (x > max) { return max; }
 
@@ -41,12 +48,19 @@ namespace rtw {
 	}
 
 	// Expand
-	Interval Interval::expand(double delta) const {
+	template <typename T>
+	basic_interval<T> basic_interval<T>::expand(T delta) const {
 		auto padding = delta / 2;
-		return Interval(min - padding, max + padding);
+		return basic_interval(min - padding, max + padding);
 	}
 
 	// Values of thoes useful Intervals
-	const Interval Interval::empty = Interval(INF, -INF);
-	const Interval Interval::universe = Interval(-INF, INF);
-}
\ No newline at end of file
+	template <typename T>
+	const basic_interval<T> basic_interval<T>::empty = basic_interval<T>(T(INF), T(-INF));
+	template <typename T>
+	const basic_interval<T> basic_interval<T>::universe = basic_interval<T>(T(-INF), T(INF));
+
+	// The two precisions we ever use
+	template class basic_interval<float>;
+	template class basic_interval<double>;
+}
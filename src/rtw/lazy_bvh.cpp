@@ -0,0 +1,116 @@
+// lazy_bvh.cpp - Implementation of the lazy_bvh_node class
+// Ethan Rudy
+
+#include "../../include/rtw/lazy_bvh.h"
+
+namespace rtw {
+
+	// List Constructor
+	lazy_bvh_node::lazy_bvh_node(const HittableList& list, size_t threshold)
+		: lazy_bvh_node(std::make_shared<std::vector<std::shared_ptr<Hittable>>>(list.objects),
+			0, list.objects.size(), threshold) {}
+
+	// Shared Vector Constructor
+	lazy_bvh_node::lazy_bvh_node(std::shared_ptr<std::vector<std::shared_ptr<Hittable>>> objects,
+		size_t start, size_t end, size_t threshold)
+		: objects(objects), start(start), end(end), threshold(std::max<size_t>(threshold, 2)), built(false) {
+
+		// Box only, no sorting yet
+		bbox = aabb::empty;
+		for (size_t object_index = start; object_index < end; ++object_index) {
+			bbox = aabb(bbox, (*objects)[object_index]->bounding_box());
+		}
+
+		// Small enough to build right away (only ever the root, make_child
+		// doesn't make lazy nodes this small)
+		if (end > start && end - start <= this->threshold) {
+			build();
+			built.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	// Hit
+	// Only the closest hit's record gets built
+	bool lazy_bvh_node::hit(const ray& r, Interval ray_t, hit_record& rec) const {
+		return deferred_hit(r, ray_t, rec);
+	}
+
+	// Intersect
+	bool lazy_bvh_node::intersect(const ray& r, Interval ray_t, hit_info& info) const {
+		if (start == end || !bbox.hit(r, ray_t)) { return false; }
+
+		ensure_built();
+
+		bool hit_left = left->intersect(r, ray_t, info);
+		bool hit_right = right->intersect(r, Interval(ray_t.min, hit_left ? info.t : ray_t.max), info);
+
+		return hit_left || hit_right;
+	}
+
+	// Occluded
+	bool lazy_bvh_node::occluded(const ray& r, Interval ray_t) const {
+		if (start == end || !bbox.hit(r, ray_t)) { return false; }
+
+		ensure_built();
+
+		return left->occluded(r, ray_t) || right->occluded(r, ray_t);
+	}
+
+	// Bounding Box
+	aabb lazy_bvh_node::bounding_box() const {
+		return bbox;
+	}
+
+	// Is Built
+	bool lazy_bvh_node::is_built() const {
+		return built.load(std::memory_order_acquire);
+	}
+
+	// Ensure Built
+	void lazy_bvh_node::ensure_built() const {
+		// Fast path, already built and published
+		if (built.load(std::memory_order_acquire)) { return; }
+
+		std::lock_guard<std::mutex> lock(build_mutex);
+
+		// Someone else might have built it while we waited on the lock
+		if (built.load(std::memory_order_relaxed)) { return; }
+
+		build();
+		built.store(true, std::memory_order_release);
+	}
+
+	// Build
+	void lazy_bvh_node::build() const {
+		// Single object, nothing to split
+		if (end - start == 1) {
+			left = right = (*objects)[start];
+			return;
+		}
+
+		// Sort our own range by box centroid along the longest axis
+		// Other nodes only ever touch their own (disjoint) ranges
+		int axis = bbox.longest_axis();
+		std::sort(objects->begin() + start, objects->begin() + end,
+			[axis](const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b) {
+				auto a_axis_interval = a->bounding_box().axis_interval(axis);
+				auto b_axis_interval = b->bounding_box().axis_interval(axis);
+				return a_axis_interval.min + a_axis_interval.max < b_axis_interval.min + b_axis_interval.max;
+			});
+
+		auto mid = start + (end - start) / 2;
+		left = make_child(start, mid);
+		right = make_child(mid, end);
+	}
+
+	// Make Child
+	std::shared_ptr<Hittable> lazy_bvh_node::make_child(size_t child_start, size_t child_end) const {
+		size_t span = child_end - child_start;
+
+		if (span == 1) { return (*objects)[child_start]; }
+		if (span <= threshold) { return std::make_shared<bvh_node>(*objects, child_start, child_end); }
+
+		return std::make_shared<lazy_bvh_node>(objects, child_start, child_end, threshold);
+	}
+
+}
@@ -0,0 +1,51 @@
+// material_table.cpp - Implementation of the MaterialTable class
+// Ethan Rudy
+
+#include "../../include/rtw/material_table.h"
+
+namespace rtw {
+
+	// Default Constructor
+	MaterialTable::MaterialTable() {}
+
+	// Add Material
+	mat_id MaterialTable::add(std::shared_ptr<material> mat) {
+		owned.push_back(mat);
+		return add(static_cast<const material*>(mat.get()));
+	}
+
+	// Add Material (not owned)
+	mat_id MaterialTable::add(const material* mat) {
+		material_kind k = material_kind::other;
+		if (dynamic_cast<const lambertian*>(mat)) { k = material_kind::lambertian; }
+		else if (dynamic_cast<const metal*>(mat)) { k = material_kind::metal; }
+		else if (dynamic_cast<const dielectric*>(mat)) { k = material_kind::dielectric; }
+		else if (dynamic_cast<const diffuse_light*>(mat)) { k = material_kind::light; }
+
+		materials.push_back(mat);
+		kinds.push_back(k);
+		return mat_id(materials.size() - 1);
+	}
+
+	// Material Lookup
+	const material& MaterialTable::operator[](mat_id id) const {
+		return *materials[id];
+	}
+
+	// Material Kind
+	material_kind MaterialTable::kind(mat_id id) const {
+		return kinds[id];
+	}
+
+	// Size
+	size_t MaterialTable::size() const {
+		return materials.size();
+	}
+
+	// Clear
+	void MaterialTable::clear() {
+		materials.clear();
+		kinds.clear();
+		owned.clear();
+	}
+}
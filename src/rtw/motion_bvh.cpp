@@ -0,0 +1,104 @@
+// motion_bvh.cpp - Implementation of the motion_bvh_node class
+// Ethan Rudy
+
+#include "../../include/rtw/motion_bvh.h"
+
+namespace rtw {
+
+	// List Constructor
+	motion_bvh_node::motion_bvh_node(HittableList list) : motion_bvh_node(list.objects, 0, list.objects.size()) {}
+
+	// Vector Constructor
+	motion_bvh_node::motion_bvh_node(std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end) {
+		// Create new bbox
+		bbox = aabb::empty;
+
+		// Add all selected objects
+		for (size_t object_index = start; object_index < end; ++object_index) {
+			bbox = aabb(bbox, objects[object_index]->bounding_box());
+		}
+
+		// Axis to split
+		int axis = bbox.longest_axis();
+
+		size_t object_span = end - start;
+
+		// One object
+		if (object_span == 1) {
+			left = right = objects[start];
+		}
+		// Two objects
+		else if (object_span == 2) {
+			left = objects[start];
+			right = objects[start + 1];
+		}
+		// Three or more objects
+		else {
+			// Sort the objects by axis
+			std::sort(std::begin(objects) + start, std::begin(objects) + end,
+				[axis](const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
+					return box_compare(a, b, axis);
+				});
+
+			// Send the objects to the next level in the hierarchy
+			auto mid = start + object_span / 2;
+			left = std::make_shared<motion_bvh_node>(objects, start, mid);
+			right = std::make_shared<motion_bvh_node>(objects, mid, end);
+		}
+
+		// Key boxes, built from the children at the same key times
+		// so nested nodes line up exactly on the keys
+		for (int key = 0; key <= TIME_SEGMENTS; ++key) {
+			real time = real(key) / TIME_SEGMENTS;
+			keys[key] = aabb(left->bounding_box_at(time), right->bounding_box_at(time));
+		}
+	}
+
+	// Hit
+	// Only the closest hit's record gets built
+	bool motion_bvh_node::hit(const ray& r, Interval ray_t, hit_record& rec) const {
+		return deferred_hit(r, ray_t, rec);
+	}
+
+	// Intersect
+	bool motion_bvh_node::intersect(const ray& r, Interval ray_t, hit_info& info) const {
+		if (!bounding_box_at(r.time()).hit(r, ray_t)) { return false; }
+
+		bool hit_left = left->intersect(r, ray_t, info);
+		bool hit_right = right->intersect(r, Interval(ray_t.min, hit_left ? info.t : ray_t.max), info);
+
+		return hit_left || hit_right;
+	}
+
+	// Occluded
+	bool motion_bvh_node::occluded(const ray& r, Interval ray_t) const {
+		if (!bounding_box_at(r.time()).hit(r, ray_t)) { return false; }
+
+		return left->occluded(r, ray_t) || right->occluded(r, ray_t);
+	}
+
+	// Bounding Box
+	aabb motion_bvh_node::bounding_box() const {
+		return bbox;
+	}
+
+	// Bounding Box at Time
+	aabb motion_bvh_node::bounding_box_at(real time) const {
+		// Find the segment, and how far along it we are
+		real s = Interval(0, 1).clamp(time) * TIME_SEGMENTS;
+		int segment = std::min(int(s), TIME_SEGMENTS - 1);
+		real f = s - segment;
+
+		return aabb::lerp(keys[segment], keys[segment + 1], f);
+	}
+
+	// Compare
+	bool motion_bvh_node::box_compare(
+		const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b, int axis_index
+	) {
+		auto a_axis_interval = a->bounding_box().axis_interval(axis_index);
+		auto b_axis_interval = b->bounding_box().axis_interval(axis_index);
+		return a_axis_interval.min + a_axis_interval.max < b_axis_interval.min + b_axis_interval.max;
+	}
+
+}
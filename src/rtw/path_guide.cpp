@@ -0,0 +1,320 @@
+// path_guide.cpp - Implementation of the PathGuide class
+// Ethan Rudy
+
+#include "../../include/rtw/path_guide.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rtw {
+
+	// Quadtree Node
+	PathGuide::quad_node::quad_node() {
+		for (int q = 0; q < 4; ++q) {
+			sum[q].store(0, std::memory_order_relaxed);
+			child[q] = 0;
+		}
+	}
+
+	// Quadtree Node (copy)
+	PathGuide::quad_node::quad_node(const quad_node& other) { *this = other; }
+
+	// Quadtree Node (assignment)
+	PathGuide::quad_node& PathGuide::quad_node::operator=(const quad_node& other) {
+		for (int q = 0; q < 4; ++q) {
+			sum[q].store(other.sum[q].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			child[q] = other.child[q];
+		}
+		return *this;
+	}
+
+	// Quadtree Node Value
+	float PathGuide::quad_node::value(int q) const {
+		return float(double(sum[q].load(std::memory_order_relaxed)) / SUM_SCALE);
+	}
+
+	// Quadtree, just the root
+	PathGuide::quadtree::quadtree() : nodes(1) {}
+
+	// Quadtree Total
+	float PathGuide::quadtree::total() const {
+		float t = 0;
+		for (int q = 0; q < 4; ++q) { t += nodes[0].value(q); }
+		return t;
+	}
+
+	/**
+	* Direction To Square
+	* Equal area: z (cos theta) down one side, phi along the other
+	*
+	* @param d	Unit direction
+	*
+	* @return Position in [0, 1)^2 as x and y, z is 0
+	*/
+	static vec3 direction_to_square(const vec3& d) {
+		real x = (std::fmax(real(-1), std::fmin(real(1), d.z())) + 1) / 2;
+		real phi = std::atan2(d.y(), d.x());
+		if (phi < 0) { phi += real(2 * PI); }
+
+		const real below_one = 1 - std::numeric_limits<real>::epsilon();
+		return vec3(std::fmin(x, below_one), std::fmin(phi / real(2 * PI), below_one), 0);
+	}
+
+	/**
+	* Square To Direction
+	*
+	* @param s	Position in [0, 1)^2
+	*
+	* @return Unit direction
+	*/
+	static vec3 square_to_direction(const vec3& s) {
+		real cos_theta = 2 * s.x() - 1;
+		real sin_theta = std::sqrt(std::fmax(real(0), 1 - cos_theta * cos_theta));
+		real phi = real(2 * PI) * s.y();
+		return vec3(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+	}
+
+	// Default Constructor
+	PathGuide::PathGuide() : origin(0, 0, 0), size(1) {}
+
+	// Reset
+	void PathGuide::reset(const aabb& bounds) {
+		// Cube around the box, so every split halves a cube-ish box
+		real extent = std::fmax(bounds.x.size(), std::fmax(bounds.y.size(), bounds.z.size()));
+		size = std::fmax(extent, real(1e-3)) * real(1.001);
+		point3 center(
+			(bounds.x.min + bounds.x.max) / 2,
+			(bounds.y.min + bounds.y.max) / 2,
+			(bounds.z.min + bounds.z.max) / 2);
+		origin = center - vec3(size, size, size) / 2;
+
+		nodes.assign(1, { { 0, 0 }, 0 });
+		sampling.assign(1, quadtree());
+		building.assign(1, quadtree());
+		std::vector<std::atomic<std::uint32_t>>(1).swap(records);
+	}
+
+	// Region
+	std::uint32_t PathGuide::region(const point3& p) const {
+		// Where p is in the cube, halved at every level
+		vec3 local = (p - origin) / size;
+		std::uint32_t node = 0;
+		int axis = 0;
+
+		while (nodes[node].child[0] != 0) {
+			real& c = local[axis];
+			int side = c >= real(0.5);
+			c = 2 * c - side;
+
+			node = nodes[node].child[side];
+			axis = (axis + 1) % 3;
+		}
+
+		return nodes[node].region;
+	}
+
+	// Trained
+	bool PathGuide::trained(std::uint32_t region) const {
+		return sampling[region].total() > 0;
+	}
+
+	// Sample
+	vec3 PathGuide::sample(std::uint32_t region, const vec3& u, real& pdf) const {
+		const quadtree& tree = sampling[region];
+		real ux = u.x(), uy = u.y();
+		real x = 0, y = 0, width = 1;
+		real square_pdf = 1;
+		std::uint32_t node = 0;
+
+		for (;;) {
+			const quad_node& n = tree.nodes[node];
+			real s[4];
+			for (int q = 0; q < 4; ++q) { s[q] = n.value(q); }
+			real total = s[0] + s[1] + s[2] + s[3];
+
+			// Left or right half, then top or bottom within it, reusing u each time
+			real left = s[0] + s[2];
+			real p_left = total > 0 ? left / total : real(0.5);
+			int qx = ux >= p_left;
+			ux = qx ? (ux - p_left) / (1 - p_left) : ux / p_left;
+
+			real column = s[qx] + s[qx + 2];
+			real p_top = column > 0 ? s[qx] / column : real(0.5);
+			int qy = uy >= p_top;
+			uy = qy ? (uy - p_top) / (1 - p_top) : uy / p_top;
+
+			int q = qx + 2 * qy;
+			square_pdf *= total > 0 ? 4 * s[q] / total : real(0);
+
+			width /= 2;
+			x += qx * width;
+			y += qy * width;
+
+			if (n.child[q] == 0) { break; }
+			node = n.child[q];
+		}
+
+		// Anywhere in the leaf
+		const real below_one = 1 - std::numeric_limits<real>::epsilon();
+		vec3 s(x + width * std::fmin(ux, below_one), y + width * std::fmin(uy, below_one), 0);
+
+		// The mapping is equal area, the sphere is 4 pi to the square's 1
+		pdf = square_pdf / real(4 * PI);
+		return square_to_direction(s);
+	}
+
+	// PDF
+	real PathGuide::pdf(std::uint32_t region, const vec3& direction) const {
+		const quadtree& tree = sampling[region];
+		if (tree.total() <= 0) { return 0; }
+
+		vec3 s = direction_to_square(direction);
+		real x = s.x(), y = s.y();
+		real square_pdf = 1;
+		std::uint32_t node = 0;
+
+		for (;;) {
+			const quad_node& n = tree.nodes[node];
+			int qx = x >= real(0.5), qy = y >= real(0.5);
+			int q = qx + 2 * qy;
+			x = 2 * x - qx;
+			y = 2 * y - qy;
+
+			real total = 0;
+			for (int i = 0; i < 4; ++i) { total += n.value(i); }
+			if (total <= 0) { return 0; }
+			square_pdf *= 4 * n.value(q) / total;
+
+			if (n.child[q] == 0) { break; }
+			node = n.child[q];
+		}
+
+		return square_pdf / real(4 * PI);
+	}
+
+	// Record
+	void PathGuide::record(std::uint32_t region, const vec3& direction, real radiance) {
+		if (!(radiance > 0) || !std::isfinite(radiance)) { return; }
+
+		// Integer adds give the same sums in any order, float adds don't
+		std::uint64_t amount = std::uint64_t(std::llround(std::fmin(double(radiance), MAX_RECORD) * SUM_SCALE));
+		if (amount == 0) { return; }
+
+		quadtree& tree = building[region];
+		vec3 s = direction_to_square(direction);
+		real x = s.x(), y = s.y();
+		std::uint32_t node = 0;
+
+		// Every quadrant on the way down gets it, so each node's sums are its children's
+		for (;;) {
+			quad_node& n = tree.nodes[node];
+			int qx = x >= real(0.5), qy = y >= real(0.5);
+			int q = qx + 2 * qy;
+			x = 2 * x - qx;
+			y = 2 * y - qy;
+
+			n.sum[q].fetch_add(amount, std::memory_order_relaxed);
+
+			if (n.child[q] == 0) { break; }
+			node = n.child[q];
+		}
+
+		records[region].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Refine
+	void PathGuide::refine(int pass) {
+		// Record counts go up with the samples, so the bar does too (sqrt
+		// keeps the regions getting smaller as the passes go on)
+		double threshold = SPATIAL_THRESHOLD * std::sqrt(std::pow(2.0, pass));
+
+		std::vector<double> counts(records.size());
+		for (size_t r = 0; r < records.size(); ++r) { counts[r] = records[r].load(std::memory_order_relaxed); }
+
+		// Only the leaves there are now, new ones were just split enough
+		struct leaf { std::uint32_t node; int depth; };
+		std::vector<leaf> leaves;
+		std::vector<leaf> stack = { { 0, 0 } };
+		while (!stack.empty()) {
+			leaf l = stack.back();
+			stack.pop_back();
+			if (nodes[l.node].child[0] == 0) { leaves.push_back(l); continue; }
+			stack.push_back({ nodes[l.node].child[0], l.depth + 1 });
+			stack.push_back({ nodes[l.node].child[1], l.depth + 1 });
+		}
+		for (const leaf& l : leaves) {
+			split_region(l.node, l.depth, counts[nodes[l.node].region], threshold);
+		}
+
+		// What was built gets sampled, and building starts over, split where the light was
+		sampling.resize(building.size());
+		for (size_t r = 0; r < building.size(); ++r) {
+			sampling[r] = building[r];
+			building[r] = refined(building[r]);
+		}
+
+		std::vector<std::atomic<std::uint32_t>>(building.size()).swap(records);
+	}
+
+	// Split Region
+	void PathGuide::split_region(std::uint32_t node, int depth, double count, double threshold) {
+		if (count <= threshold || depth >= MAX_SPATIAL_DEPTH) { return; }
+
+		// First half keeps the region, second half gets a copy of it
+		std::uint32_t region = nodes[node].region;
+		std::uint32_t copy = std::uint32_t(building.size());
+		building.push_back(building[region]);
+
+		std::uint32_t first = std::uint32_t(nodes.size());
+		nodes.push_back({ { 0, 0 }, region });
+		nodes.push_back({ { 0, 0 }, copy });
+		nodes[node].child[0] = first;
+		nodes[node].child[1] = first + 1;
+
+		// Records are assumed to be split evenly
+		split_region(first, depth + 1, count / 2, threshold);
+		split_region(first + 1, depth + 1, count / 2, threshold);
+	}
+
+	// Refined
+	PathGuide::quadtree PathGuide::refined(const quadtree& tree) {
+		quadtree out;
+		float total = tree.total();
+		if (total <= 0) { return out; }
+
+		// New node, the old node it copies (0 when it's splitting an old
+		// leaf, the root can't be a child), its quadrants' light, and depth
+		struct entry {
+			std::uint32_t node, old;
+			float sum[4];
+			int depth;
+		};
+
+		entry root = { 0, 0, {}, 1 };
+		for (int q = 0; q < 4; ++q) { root.sum[q] = tree.nodes[0].value(q); }
+
+		std::vector<entry> stack = { root };
+		while (!stack.empty()) {
+			entry e = stack.back();
+			stack.pop_back();
+			if (e.depth >= MAX_QUAD_DEPTH) { continue; }
+
+			for (int q = 0; q < 4; ++q) {
+				if (e.sum[q] <= QUAD_THRESHOLD * total) { continue; }
+
+				entry child = { std::uint32_t(out.nodes.size()), 0, {}, e.depth + 1 };
+				std::uint32_t old_child = (e.node == 0 || e.old != 0) ? tree.nodes[e.old].child[q] : 0;
+				for (int c = 0; c < 4; ++c) {
+					child.sum[c] = old_child ? tree.nodes[old_child].value(c) : e.sum[q] / 4;
+				}
+				child.old = old_child;
+
+				out.nodes.emplace_back();
+				out.nodes[e.node].child[q] = child.node;
+				stack.push_back(child);
+			}
+		}
+
+		return out;
+	}
+
+}
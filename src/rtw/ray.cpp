@@ -6,17 +6,20 @@
 namespace rtw {
 
 	// Default Constructor
-	ray::ray() {}
+	template <typename T>
+	basic_ray<T>::basic_ray() : tm(0) {}
 
 	// Time Constructor
-	ray::ray(const point3& origin, const vec3& direction, double time) {
+	template <typename T>
+	basic_ray<T>::basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction, T time) {
 		orig = origin;
 		dir = direction;
 		tm = time;
 	}
 
 	// Timeless Constructor
-	ray::ray(const point3& origin, const vec3& direction) {
+	template <typename T>
+	basic_ray<T>::basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction) {
 		orig = origin;
 		dir = direction;
 		tm = 0;
@@ -25,20 +28,56 @@ namespace rtw {
 	
 
 	// Origin Accessor
-	const point3& ray::origin() const {
+	template <typename T>
+	const basic_vec3<T>& basic_ray<T>::origin() const {
 		return orig;
 	}
 
 	// Direction Accessor
-	const point3& ray::direction() const {
+	template <typename T>
+	const basic_vec3<T>& basic_ray<T>::direction() const {
 		return dir;
 	}
 
 	// Time Accessor
-	double ray::time() const { return tm; }
+	template <typename T>
+	T basic_ray<T>::time() const { return tm; }
 
 	// Ray at Time 't'
-	point3 ray::at(double t) const {
+	template <typename T>
+	basic_vec3<T> basic_ray<T>::at(T t) const {
 		return orig + t * dir;
 	}
-}
\ No newline at end of file
+
+	// The two precisions we ever use
+	template class basic_ray<float>;
+	template class basic_ray<double>;
+
+
+
+	// Offset Ray Origin
+	template <typename T>
+	basic_vec3<T> offset_ray_origin(const basic_vec3<T>& p, const basic_vec3<T>& p_error,
+		const basic_vec3<T>& n, const basic_vec3<T>& dir) {
+
+		// Distance along n to the far side of the error box
+		T d = std::fabs(n[0]) * p_error[0] + std::fabs(n[1]) * p_error[1] + std::fabs(n[2]) * p_error[2];
+		basic_vec3<T> offset = d * n;
+		if (dot(dir, n) < 0) { offset = -offset; }
+
+		basic_vec3<T> po = p + offset;
+
+		// p + offset rounds too, step one more float away so it can't land back inside
+		for (int i = 0; i < 3; ++i) {
+			if (offset[i] > 0) { po[i] = std::nextafter(po[i], T(INF)); }
+			else if (offset[i] < 0) { po[i] = std::nextafter(po[i], T(-INF)); }
+		}
+
+		return po;
+	}
+
+	template basic_vec3<float> offset_ray_origin(const basic_vec3<float>&, const basic_vec3<float>&,
+		const basic_vec3<float>&, const basic_vec3<float>&);
+	template basic_vec3<double> offset_ray_origin(const basic_vec3<double>&, const basic_vec3<double>&,
+		const basic_vec3<double>&, const basic_vec3<double>&);
+}
@@ -0,0 +1,89 @@
+// ray_packet.cpp - Implementation of the ray_packet struct
+// Ethan Rudy
+
+#include "../../include/rtw/ray_packet.h"
+#include <algorithm>
+
+namespace rtw {
+
+	// Clear
+	void ray_packet::clear() {
+		size = 0;
+	}
+
+	// Add
+	void ray_packet::add(const ray& r) {
+		if (size >= MAX_RAYS) { return; }
+
+		const vec3& d = r.direction();
+		rays[size] = r;
+		inv_dir[size] = vec3(1 / d[0], 1 / d[1], 1 / d[2]);
+		++size;
+	}
+
+	// Finalize
+	void ray_packet::finalize() {
+		for (int axis = 0; axis < 3; ++axis) {
+			origin[axis] = Interval::empty;
+			inv_dir_bounds[axis] = Interval::empty;
+
+			bool all_positive = true, all_negative = true;
+			for (int i = 0; i < size; ++i) {
+				real o = rays[i].origin()[axis];
+				real d = rays[i].direction()[axis];
+				origin[axis] = Interval(std::min(origin[axis].min, o), std::max(origin[axis].max, o));
+				inv_dir_bounds[axis] = Interval(std::min(inv_dir_bounds[axis].min, inv_dir[i][axis]),
+					std::max(inv_dir_bounds[axis].max, inv_dir[i][axis]));
+				all_positive = all_positive && d > 0;
+				all_negative = all_negative && d < 0;
+			}
+
+			same_sign[axis] = size > 0 && (all_positive || all_negative);
+		}
+
+		time = Interval::empty;
+		for (int i = 0; i < size; ++i) {
+			time = Interval(std::min(time.min, rays[i].time()), std::max(time.max, rays[i].time()));
+		}
+	}
+
+	// All
+	std::uint64_t ray_packet::all() const {
+		return size >= MAX_RAYS ? ~std::uint64_t(0) : (std::uint64_t(1) << size) - 1;
+	}
+
+	// May Hit
+	bool ray_packet::may_hit(const aabb& box, Interval ray_t) const {
+		// Interval product, [a.min, a.max] * [b.min, b.max]
+		auto mul = [](real a0, real a1, const Interval& b) {
+			real p0 = a0 * b.min, p1 = a0 * b.max, p2 = a1 * b.min, p3 = a1 * b.max;
+			return Interval(std::min(std::min(p0, p1), std::min(p2, p3)), std::max(std::max(p0, p1), std::max(p2, p3)));
+		};
+
+		for (int axis = 0; axis < 3; ++axis) {
+			// Directions straddling 0 put no bound on this axis
+			if (!same_sign[axis]) { continue; }
+
+			const Interval& slab = box.axis_interval(axis);
+			const Interval& o = origin[axis];
+			const Interval& inv = inv_dir_bounds[axis];
+
+			// Entry plane is the near side of the slab in the direction of travel
+			bool positive = inv.min > 0;
+			real near_plane = positive ? slab.min : slab.max;
+			real far_plane = positive ? slab.max : slab.min;
+
+			// Earliest any ray can enter, latest any ray can leave
+			Interval t_near = mul(near_plane - o.max, near_plane - o.min, inv);
+			Interval t_far = mul(far_plane - o.max, far_plane - o.min, inv);
+
+			if (t_near.min > ray_t.min) ray_t.min = t_near.min;
+			if (t_far.max < ray_t.max) ray_t.max = t_far.max;
+
+			if (ray_t.max < ray_t.min) { return false; }
+		}
+
+		return true;
+	}
+
+}
@@ -29,21 +29,27 @@ namespace rtw {
 				output_data[3 * (y * WIDTH + x) + 0] = 0;
 				output_data[3 * (y * WIDTH + x) + 1] = 0;
 				output_data[3 * (y * WIDTH + x) + 2] = 0;
-
-				pixels.push_back(coord(x, y));
 			}
 		}
 
 		/**
 		* I wanted to do a threadpool and have it render like cinebench,
-		* But my threadpool wasn't happy with me, so I store all pixel
-		* (x, y) coordinates, randomize the entire list, and then
-		* divide it into spans that each thread renders individually.
+		* But my threadpool wasn't happy with me, so I store all tile
+		* rectangles, randomize the entire list, and then divide it into
+		* spans that each thread renders individually.
+		* 
+		* Tiles (rather than single pixels) so each thread's camera rays
+		* come in coherent packets, edge tiles are just smaller.
 		*/
+		for (int y = 0; y < int(HEIGHT); y += TILE_SIZE) {
+			for (int x = 0; x < int(WIDTH); x += TILE_SIZE) {
+				tiles.push_back(tile(x, y, std::min<int>(x + TILE_SIZE, WIDTH), std::min<int>(y + TILE_SIZE, HEIGHT)));
+			}
+		}
 
-		// Scramble pixels
+		// Scramble tiles
 		auto rng = std::default_random_engine{};
-		std::shuffle(pixels.begin(), pixels.end(), rng);
+		std::shuffle(tiles.begin(), tiles.end(), rng);
 
 		// Write blackout pixels
 		stbi_write_jpg("./textures/output.jpg", WIDTH, HEIGHT, 3, output_data, WIDTH * 3);
@@ -54,7 +60,7 @@ namespace rtw {
 		// One thread renders the screen, one thread manages the ray tracer, and the (N_THREADS - 2) do the math
 		// If I stick with the normal (16 in my case), everything else on my PC gets stuttery bc all cores are firing
 		// at this ONE program
-		N_THREADS -= 2;
+		N_THREADS = std::max(N_THREADS - 2, 1);
 
 		// Progress indicators
 		so_far = 0;
@@ -65,8 +71,8 @@ namespace rtw {
 
 		// WORLD CREATION
 
-		auto ground_material = make_shared<lambertian>(color(0.5, 0.5, 0.5));
-		world.add(make_shared<Sphere>(point3(0, -1000, 0), 1000, ground_material));
+		auto ground_material = world.add_material<lambertian>(color(0.5, 0.5, 0.5));
+		world.add_sphere(point3(0, -1000, 0), 1000, ground_material);
 
 		for (int a = -11; a < 11; a++) {
 			for (int b = -11; b < 11; b++) {
@@ -74,41 +80,45 @@ namespace rtw {
 				point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
 
 				if ((center - point3(4, 0.2, 0)).length() > 0.9) {
-					shared_ptr<material> sphere_material;
+					mat_id sphere_material;
 
 					if (choose_mat < 0.8) {
 						// diffuse
 						auto albedo = color::random() * color::random();
-						sphere_material = make_shared<lambertian>(albedo);
+						sphere_material = world.add_material<lambertian>(albedo);
 						auto center2 = center + vec3(0, random_double(0, .5), 0);
-						world.add(make_shared<Sphere>(center, center2, 0.2, sphere_material));
+						world.add_moving_sphere(center, center2, 0.2, sphere_material);
 					}
 					else if (choose_mat < 0.95) {
 						// metal
 						auto albedo = color::random(0.5, 1);
 						auto fuzz = random_double(0, 0.5);
-						sphere_material = make_shared<metal>(albedo, fuzz);
-						world.add(make_shared<Sphere>(center, 0.2, sphere_material));
+						sphere_material = world.add_material<metal>(albedo, fuzz);
+						world.add_sphere(center, 0.2, sphere_material);
 					}
 					else {
 						// glass
-						sphere_material = make_shared<dielectric>(1.5);
-						world.add(make_shared<Sphere>(center, 0.2, sphere_material));
+						sphere_material = world.add_material<dielectric>(1.5);
+						world.add_sphere(center, 0.2, sphere_material);
 					}
 				}
 			}
 		}
 
-		auto material1 = make_shared<dielectric>(1.5);
-		world.add(make_shared<Sphere>(point3(0, 1, 0), 1.0, material1));
+		auto material1 = world.add_material<dielectric>(1.5);
+		world.add_sphere(point3(0, 1, 0), 1.0, material1);
 
-		auto material2 = make_shared<lambertian>(color(0.4, 0.2, 0.1));
-		world.add(make_shared<Sphere>(point3(-4, 1, 0), 1.0, material2));
+		auto material2 = world.add_material<lambertian>(color(0.4, 0.2, 0.1));
+		world.add_sphere(point3(-4, 1, 0), 1.0, material2);
 
-		auto material3 = make_shared<metal>(color(0.7, 0.6, 0.5), 0.0);
-		world.add(make_shared<Sphere>(point3(4, 1, 0), 1.0, material3));
+		auto material3 = world.add_material<metal>(color(0.7, 0.6, 0.5), 0.0);
+		world.add_sphere(point3(4, 1, 0), 1.0, material3);
 
-		world = HittableList(make_shared<bvh_node>(world));
+		// Image based lighting, an HDR environment map instead of the sky gradient
+		// world.set_environment(std::make_shared<EnvironmentMap>("./textures/environment.hdr", true));
+
+		// Flat BVH over the primitive arrays
+		world.build();
 
 
 		// Camera settings
@@ -125,21 +135,87 @@ namespace rtw {
 		camera.defocus_angle = 0.6;
 		camera.focus_dist = 10.0;
 
+		camera.wavefront = false;
+
+		// Path guiding, a few short passes first to learn where the light
+		// comes from (see path_guide.h), worth it once paths struggle to find it
+		guiding = false;
+		guide_passes = 4;
+
+		// Denoising, the final image is filtered guided by the albedo and
+		// normal of what each pixel sees first (see denoiser.h), low sample
+		// counts look far cleaner for a bit of blur
+		denoising = false;
+
 		// Initialize Camera
 		camera.init();
 	}
 
 	// Render
 	void RayTracer::render() {
+		// Every pass counts toward the progress bar
+		total_pixels = WIDTH * HEIGHT * (guiding ? guide_passes + 1 : 1);
+
+		if (guiding) {
+			guide.reset(world.bounding_box());
+
+			// Training passes double their samples each time, each gets its own seed.
+			// Their images are thrown away (well, shown until the next one's done)
+			for (int pass = 0; pass < guide_passes; ++pass) {
+				Camera trainer = camera;
+				trainer.samples = 1 << pass;
+				trainer.seed = camera.seed + std::uint32_t(pass) + 1;
+				trainer.wavefront = false;
+				trainer.guide = &guide;
+				trainer.train_guide = true;
+				trainer.init();
+
+				render_pass(trainer);
+				guide.refine(pass);
+			}
+
+			camera.guide = &guide;
+		}
+
+		if (denoising) {
+			buffers.resize(WIDTH, HEIGHT);
+			camera.buffers = &buffers;
+		}
+
+		render_pass(camera);
+
+		// Filter the final pass, and show that instead
+		if (denoising) {
+			std::vector<float> denoised;
+			denoiser.denoise(buffers, denoised, N_THREADS);
+			for (unsigned y = 0; y < HEIGHT; ++y) {
+				for (unsigned x = 0; x < WIDTH; ++x) {
+					const float* c = &denoised[3 * (size_t(y) * WIDTH + x)];
+					Camera::write_color(output_data, WIDTH, x, y, color(c[0], c[1], c[2]));
+				}
+			}
+		}
+
+		// Flag the render as complete
+		_done = true;
+	}
+
+	// Render Pass
+	void RayTracer::render_pass(const Camera& pass_camera) {
 		// Create thread vector and calculate span width
 		std::vector<std::thread> render_threads;
-		int span = pixels.size() / N_THREADS;
+		int span = tiles.size() / N_THREADS;
 		int s_start = 0;
 
+		// Either engine renders a span the same way
+		auto render_span = pass_camera.wavefront ? &Camera::render_span_wavefront : &Camera::render_span;
+
 		// Create subspan threads, walking along the span
+		// The last thread also picks up the leftover tiles
 		for (int i = 0; i < N_THREADS; ++i) {
-			render_threads.push_back(std::thread(&Camera::render_span, camera, std::ref(world), s_start, s_start + span, output_data, std::ref(pixels), std::ref(so_far)));
-			s_start += span;
+			int s_end = (i == N_THREADS - 1) ? int(tiles.size()) : s_start + span;
+			render_threads.push_back(std::thread(render_span, pass_camera, std::cref(world), s_start, s_end, output_data, std::ref(tiles), std::ref(so_far)));
+			s_start = s_end;
 		}
 
 		// Join threads
@@ -148,9 +224,6 @@ namespace rtw {
 				t.join();
 			}
 		}
-
-		// Flag the render as complete
-		_done = true;
 	}
 
 	// Write
@@ -183,6 +256,36 @@ namespace rtw {
 		std::cout << bar << " " << std::setprecision(4) << " " << percent << "%      ";
 	}
 
+	// Benchmark
+	void RayTracer::benchmark(int n_rays) const {
+		// Segments between two random points in (and just above) the sphere field,
+		// like a shadow ray from a hit to a point on a light
+		std::vector<ray> rays;
+		rays.reserve(n_rays);
+		for (int i = 0; i < n_rays; ++i) {
+			point3 from(random_double(-11, 11), random_double(0, 2), random_double(-11, 11));
+			point3 to(random_double(-11, 11), random_double(0, 2), random_double(-11, 11));
+			rays.push_back(ray(from, to - from, random_double()));
+		}
+
+		using clock = std::chrono::steady_clock;
+		int n_hit = 0, n_occluded = 0;
+		hit_record rec;
+
+		auto start = clock::now();
+		for (const ray& r : rays) { n_hit += world.hit(r, Interval(0, 1), rec); }
+		double hit_time = std::chrono::duration<double>(clock::now() - start).count();
+
+		start = clock::now();
+		for (const ray& r : rays) { n_occluded += world.occluded(r, Interval(0, 1)); }
+		double occluded_time = std::chrono::duration<double>(clock::now() - start).count();
+
+		std::cout << std::setprecision(4)
+			<< "hit:      " << n_rays / hit_time / 1e6 << " Mrays/s (" << n_hit << " hits)\n"
+			<< "occluded: " << n_rays / occluded_time / 1e6 << " Mrays/s (" << n_occluded << " hits)\n"
+			<< "speedup:  " << hit_time / occluded_time << "x\n";
+	}
+
 	// Done
 	bool RayTracer::done() const {
 		return _done;
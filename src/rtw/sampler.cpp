@@ -0,0 +1,423 @@
+// sampler.cpp - Implementation of the Sampler classes
+// Ethan Rudy
+
+#include "../../include/rtw/sampler.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace rtw {
+
+	/**
+	* Hash
+	* 32 bit integer mix (lowbias32, Chris Wellons)
+	*
+	* @param x	Value
+	*
+	* @return Hash of x
+	*/
+	static std::uint32_t hash(std::uint32_t x) {
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	/**
+	* Hash Combine
+	*
+	* @param seed	Hash so far
+	* @param v		Value to mix in
+	*
+	* @return Hash of both
+	*/
+	static std::uint32_t hash_combine(std::uint32_t seed, std::uint32_t v) {
+		return seed ^ (hash(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+	}
+
+	/**
+	* Below One
+	*
+	* @param x	Value in [0, 1)
+	*
+	* @return x as a real, kept below 1 after rounding
+	*/
+	static real below_one(double x) {
+		const real ONE_MINUS_EPSILON = real(1) - std::numeric_limits<real>::epsilon() / 2;
+		return std::fmin(real(x), ONE_MINUS_EPSILON);
+	}
+
+	/**
+	* To Unit
+	*
+	* @param bits	32 bit fixed point fraction
+	*
+	* @return bits / 2^32
+	*/
+	static real to_unit(std::uint32_t bits) {
+		return below_one(bits * (1.0 / 4294967296.0));
+	}
+
+	/**
+	* Reverse Bits
+	*
+	* @param x	Value
+	*
+	* @return x with its 32 bits in reverse order
+	*/
+	static std::uint32_t reverse_bits(std::uint32_t x) {
+		x = (x << 16) | (x >> 16);
+		x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+		x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+		x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+		x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+		return x;
+	}
+
+	/**
+	* Nested Uniform Scramble
+	* Owen scrambling of a 32 bit fraction, the Laine-Karras style
+	* hash only lets lower bits affect higher ones, so it's done
+	* on the reversed bits
+	*
+	* @param x		Value
+	* @param seed	Scramble seed
+	*
+	* @return Scrambled x
+	*/
+	static std::uint32_t nested_uniform_scramble(std::uint32_t x, std::uint32_t seed) {
+		x = reverse_bits(x);
+		x += seed;
+		x ^= x * 0x6c50b47c;
+		x ^= x * 0xb82f1e52;
+		x ^= x * 0xc7afe638;
+		x ^= x * 0x8d22f6e6;
+		return reverse_bits(x);
+	}
+
+	/**
+	* Sobol 0
+	* First Sobol dimension (van der Corput)
+	*
+	* @param index	Point index
+	*
+	* @return Point as a 32 bit fraction
+	*/
+	static std::uint32_t sobol_0(std::uint32_t index) {
+		return reverse_bits(index);
+	}
+
+	/**
+	* Sobol 1
+	* Second Sobol dimension, primitive polynomial x + 1, so every
+	* direction number is the last one xor'd with itself shifted by 1
+	*
+	* @param index	Point index
+	*
+	* @return Point as a 32 bit fraction
+	*/
+	static std::uint32_t sobol_1(std::uint32_t index) {
+		std::uint32_t result = 0;
+		for (std::uint32_t v = 0x80000000u; index; index >>= 1, v ^= v >> 1) {
+			if (index & 1) { result ^= v; }
+		}
+		return result;
+	}
+
+
+	/**
+	* Permute
+	* Kensler's hashed permutation, no table needed ("Correlated
+	* Multi-Jittered Sampling", 2013)
+	*
+	* @param i		Index, in [0, n)
+	* @param n		Permutation length
+	* @param seed	Which permutation
+	*
+	* @return Where i goes in the permutation
+	*/
+	static std::uint32_t permute(std::uint32_t i, std::uint32_t n, std::uint32_t seed) {
+		std::uint32_t w = n - 1;
+		w |= w >> 1; w |= w >> 2; w |= w >> 4; w |= w >> 8; w |= w >> 16;
+
+		// Cycle walk until the result lands back inside [0, n)
+		do {
+			i ^= seed; i *= 0xe170893d; i ^= seed >> 16; i ^= (i & w) >> 4;
+			i ^= seed >> 8; i *= 0x0929eb3f; i ^= seed >> 23; i ^= (i & w) >> 1;
+			i *= 1 | seed >> 27; i *= 0x6935fa69; i ^= (i & w) >> 11; i *= 0x74dcb303;
+			i ^= (i & w) >> 2; i *= 0x9e501cc3; i ^= (i & w) >> 2; i *= 0xc860a3df;
+			i &= w; i ^= i >> 5;
+		} while (i >= n);
+
+		return (i + seed) % n;
+	}
+
+	/**
+	* Lattice Generator
+	* Picks g so the rank-1 lattice (i, i * g) / n has the largest
+	* distance between its closest two points (on the torus). A lattice
+	* is the same seen from any of its points, so that's just the
+	* closest point to the origin. Past 4096 points the search gets slow,
+	* n / golden ratio is close to the best there anyway
+	*
+	* @param n	Number of points
+	*
+	* @return Generator g, coprime to n
+	*/
+	static std::uint32_t lattice_generator(std::uint32_t n) {
+		if (n <= 2) { return 1; }
+
+		auto coprime = [](std::uint32_t a, std::uint32_t b) {
+			while (b) { std::uint32_t t = a % b; a = b; b = t; }
+			return a == 1;
+		};
+
+		if (n > 4096) {
+			std::uint32_t g = std::uint32_t(n * 0.6180339887498949);
+			while (!coprime(n, g)) { --g; }
+			return g;
+		}
+
+		std::uint32_t best = 1;
+		double best_dist = 0;
+		for (std::uint32_t g = 1; g <= n / 2; ++g) {
+			if (!coprime(n, g)) { continue; }
+
+			double closest = 1;
+			for (std::uint32_t i = 1; i < n && closest > best_dist; ++i) {
+				double u = double(i) / n, v = double(std::uint64_t(i) * g % n) / n;
+				u = std::min(u, 1 - u);
+				v = std::min(v, 1 - v);
+				closest = std::min(closest, u * u + v * v);
+			}
+
+			if (closest > best_dist) {
+				best_dist = closest;
+				best = g;
+			}
+		}
+
+		return best;
+	}
+
+	/**
+	* Make Blue Noise Tile
+	*
+	* Void and cluster: spread a few random points out evenly, then rank
+	* every pixel by the order it would be added in if pixels kept going
+	* into the largest gap (or came out of the tightest clump, for the
+	* first few). Gaps and clumps are measured with a Gaussian that wraps
+	* around the edges, so the tile tiles
+	*
+	* @return Tile, row major, every value in [0, 1) used once
+	*/
+	static std::vector<float> make_blue_noise_tile() {
+		const int SIZE = BlueNoiseSampler::TILE_SIZE, MASK = SIZE - 1, N = SIZE * SIZE;
+		const double SIGMA = 1.5;
+
+		// Gaussian by (wrapped) offset between two pixels
+		std::vector<double> splat(N);
+		for (int dy = 0; dy < SIZE; ++dy) {
+			for (int dx = 0; dx < SIZE; ++dx) {
+				int wx = std::min(dx, SIZE - dx), wy = std::min(dy, SIZE - dy);
+				splat[dy * SIZE + dx] = std::exp(-(wx * wx + wy * wy) / (2 * SIGMA * SIGMA));
+			}
+		}
+
+		std::vector<unsigned char> on(N, 0);
+		std::vector<double> energy(N, 0);
+
+		auto toggle = [&](int p) {
+			on[p] ^= 1;
+			double sign = on[p] ? 1 : -1;
+			int px = p & MASK, py = p / SIZE;
+			for (int q = 0; q < N; ++q) {
+				energy[q] += sign * splat[(((q / SIZE) - py) & MASK) * SIZE + (((q & MASK) - px) & MASK)];
+			}
+		};
+		auto tightest_cluster = [&]() {
+			int best = -1;
+			for (int q = 0; q < N; ++q) {
+				if (on[q] && (best < 0 || energy[q] > energy[best])) { best = q; }
+			}
+			return best;
+		};
+		auto largest_void = [&]() {
+			int best = -1;
+			for (int q = 0; q < N; ++q) {
+				if (!on[q] && (best < 0 || energy[q] < energy[best])) { best = q; }
+			}
+			return best;
+		};
+
+		// A tenth of the pixels at random
+		std::mt19937 generator(0x9e3779b9);
+		int initial = N / 10;
+		for (int placed = 0; placed < initial;) {
+			int p = int(generator() % N);
+			if (!on[p]) { toggle(p); ++placed; }
+		}
+
+		// Move the tightest clump into the largest gap until it moves back where it was
+		for (int i = 0; i < N; ++i) {
+			int cluster = tightest_cluster();
+			toggle(cluster);
+			int gap = largest_void();
+			toggle(gap);
+			if (gap == cluster) { break; }
+		}
+
+		std::vector<int> rank(N);
+		std::vector<unsigned char> initial_on = on;
+		std::vector<double> initial_energy = energy;
+
+		// Initial points, ranked by taking them away
+		for (int r = initial - 1; r >= 0; --r) {
+			int cluster = tightest_cluster();
+			toggle(cluster);
+			rank[cluster] = r;
+		}
+
+		// Everything else, ranked by filling gaps
+		on = initial_on;
+		energy = initial_energy;
+		for (int r = initial; r < N; ++r) {
+			int gap = largest_void();
+			toggle(gap);
+			rank[gap] = r;
+		}
+
+		std::vector<float> tile(N);
+		for (int p = 0; p < N; ++p) {
+			tile[p] = (rank[p] + 0.5f) / N;
+		}
+		return tile;
+	}
+
+	/**
+	* Blue Noise Tile
+	*
+	* @return The tile, made on the first call
+	*/
+	static const std::vector<float>& blue_noise_tile() {
+		static const std::vector<float> tile = make_blue_noise_tile();
+		return tile;
+	}
+
+
+
+	// Seed Constructor
+	IndependentSampler::IndependentSampler(std::uint32_t seed) : seed(seed), sample_seed(0) {}
+
+	// Start Pixel Sample
+	void IndependentSampler::start_pixel_sample(int x, int y, int index, int dimension) {
+		std::uint32_t pixel_seed = hash_combine(hash_combine(hash(seed), std::uint32_t(x)), std::uint32_t(y));
+		sample_seed = hash_combine(pixel_seed, std::uint32_t(index));
+		dim = dimension;
+	}
+
+	// Get 1D
+	real IndependentSampler::get_1d() {
+		return to_unit(hash(hash_combine(sample_seed, std::uint32_t(dim++))));
+	}
+
+	// Get 2D
+	vec3 IndependentSampler::get_2d() {
+		real u = to_unit(hash(hash_combine(sample_seed, std::uint32_t(dim++))));
+		real v = to_unit(hash(hash_combine(sample_seed, std::uint32_t(dim++))));
+		return vec3(u, v, 0);
+	}
+
+
+
+	// Seed Constructor
+	SobolSampler::SobolSampler(std::uint32_t seed) : seed(seed), pixel_seed(0), sample_index(0) {}
+
+	// Start Pixel Sample
+	void SobolSampler::start_pixel_sample(int x, int y, int index, int dimension) {
+		pixel_seed = hash_combine(hash_combine(hash(seed), std::uint32_t(x)), std::uint32_t(y));
+		sample_index = std::uint32_t(index);
+		dim = dimension;
+	}
+
+	// Get 1D
+	real SobolSampler::get_1d() {
+		std::uint32_t dim_seed = hash_combine(pixel_seed, std::uint32_t(dim++));
+
+		std::uint32_t index = nested_uniform_scramble(sample_index, dim_seed);
+		return to_unit(nested_uniform_scramble(sobol_0(index), hash_combine(dim_seed, 0)));
+	}
+
+	// Get 2D
+	vec3 SobolSampler::get_2d() {
+		std::uint32_t dim_seed = hash_combine(pixel_seed, std::uint32_t(dim));
+		dim += 2;
+
+		// Same shuffled index for both, so the pair stays a (0, 2) sequence
+		std::uint32_t index = nested_uniform_scramble(sample_index, dim_seed);
+		real u = to_unit(nested_uniform_scramble(sobol_0(index), hash_combine(dim_seed, 0)));
+		real v = to_unit(nested_uniform_scramble(sobol_1(index), hash_combine(dim_seed, 1)));
+		return vec3(u, v, 0);
+	}
+
+
+
+	// Seed Constructor
+	BlueNoiseSampler::BlueNoiseSampler(std::uint32_t seed, int samples)
+		: seed(seed), samples(std::uint32_t(std::max(samples, 1))), pixel_x(0), pixel_y(0), sample_index(0) {
+		generator = lattice_generator(this->samples);
+		blue_noise_tile();
+	}
+
+	// Start Pixel Sample
+	void BlueNoiseSampler::start_pixel_sample(int x, int y, int index, int dimension) {
+		pixel_x = x;
+		pixel_y = y;
+		sample_index = std::uint32_t(index) % samples;
+		dim = dimension;
+	}
+
+	// Get 1D
+	real BlueNoiseSampler::get_1d() {
+		// Same permutation and shift lookup for every pixel, only the texture differs
+		std::uint32_t dim_seed = hash_combine(hash(seed), std::uint32_t(dim++));
+
+		std::uint32_t i = permute(sample_index, samples, dim_seed);
+		double u = double(i) / samples + shift(hash_combine(dim_seed, 0));
+		return below_one(u - std::floor(u));
+	}
+
+	// Get 2D
+	vec3 BlueNoiseSampler::get_2d() {
+		std::uint32_t dim_seed = hash_combine(hash(seed), std::uint32_t(dim));
+		dim += 2;
+
+		std::uint32_t i = permute(sample_index, samples, dim_seed);
+		double u = double(i) / samples + shift(hash_combine(dim_seed, 0));
+		double v = double(std::uint64_t(i) * generator % samples) / samples + shift(hash_combine(dim_seed, 1));
+		return vec3(below_one(u - std::floor(u)), below_one(v - std::floor(v)), 0);
+	}
+
+	// Shift
+	double BlueNoiseSampler::shift(std::uint32_t key) const {
+		const int MASK = TILE_SIZE - 1;
+		std::uint32_t h = hash(key);
+		int x = (pixel_x + int(h)) & MASK;
+		int y = (pixel_y + int(h >> 16)) & MASK;
+		return blue_noise_tile()[y * TILE_SIZE + x];
+	}
+
+
+
+	// Make Sampler
+	std::unique_ptr<Sampler> make_sampler(sampler_type type, std::uint32_t seed, int samples) {
+		switch (type) {
+		case sampler_type::sobol: return std::unique_ptr<Sampler>(new SobolSampler(seed));
+		case sampler_type::blue_noise: return std::unique_ptr<Sampler>(new BlueNoiseSampler(seed, samples));
+		default: return std::unique_ptr<Sampler>(new IndependentSampler(seed));
+		}
+	}
+
+}
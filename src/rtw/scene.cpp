@@ -0,0 +1,717 @@
+// scene.cpp - Implementation of the Scene class
+// Ethan Rudy
+
+#include "../../include/rtw/scene.h"
+#include <algorithm>
+
+namespace rtw {
+
+	// Default Constructor
+	Scene::Scene() : bbox(aabb::empty), motion(false), env_light(false) {}
+
+	// Add Sphere
+	void Scene::add_sphere(const point3& center, real radius, mat_id mat) {
+		spheres.push_back({ center, std::fmax(real(0), radius), mat });
+	}
+
+	// Add Moving Sphere
+	void Scene::add_moving_sphere(const point3& center1, const point3& center2, real radius, mat_id mat) {
+		moving_spheres.push_back({ center1, center2 - center1, std::fmax(real(0), radius), mat });
+	}
+
+	// Add Object
+	void Scene::add(std::shared_ptr<Hittable> object) {
+		owned.push_back(object);
+		objects.push_back(object.get());
+	}
+
+	// Set Environment
+	void Scene::set_environment(std::shared_ptr<const EnvironmentMap> map) {
+		env = (map && map->valid()) ? map : nullptr;
+	}
+
+	// Environment
+	const EnvironmentMap* Scene::environment() const { return env.get(); }
+
+	// Clear
+	void Scene::clear() {
+		spheres.clear();
+		moving_spheres.clear();
+		objects.clear();
+		owned.clear();
+		materials.clear();
+		nodes.clear();
+		soa.clear();
+		refs.clear();
+		bbox = aabb::empty;
+		motion = false;
+		lights.clear();
+		light_cdf.clear();
+		sphere_light.clear();
+		env = nullptr;
+		env_light = false;
+		arena.release();
+	}
+
+	// Build
+	void Scene::build() {
+		std::vector<build_prim> prims;
+		prims.reserve(spheres.size() + moving_spheres.size() + objects.size());
+
+		auto add_prim = [&prims](prim_type type, size_t index, const aabb& box0, const aabb& box1) {
+			aabb swept(box0, box1);
+			point3 centroid(
+				0.5 * (swept.x.min + swept.x.max),
+				0.5 * (swept.y.min + swept.y.max),
+				0.5 * (swept.z.min + swept.z.max));
+			prims.push_back({ { type, std::uint32_t(index) }, box0, box1, centroid });
+		};
+
+		for (size_t i = 0; i < spheres.size(); ++i) {
+			const auto& s = spheres[i];
+			auto rvec = vec3(s.radius, s.radius, s.radius);
+			aabb box(s.center - rvec, s.center + rvec);
+			add_prim(prim_type::sphere, i, box, box);
+		}
+
+		for (size_t i = 0; i < moving_spheres.size(); ++i) {
+			const auto& s = moving_spheres[i];
+			auto rvec = vec3(s.radius, s.radius, s.radius);
+			point3 center2 = s.center1 + s.center_vec;
+			add_prim(prim_type::moving_sphere, i,
+				aabb(s.center1 - rvec, s.center1 + rvec), aabb(center2 - rvec, center2 + rvec));
+		}
+
+		// Objects can move however they want, so they only get their swept box
+		for (size_t i = 0; i < objects.size(); ++i) {
+			aabb box = objects[i]->bounding_box();
+			add_prim(prim_type::object, i, box, box);
+		}
+
+		nodes.clear();
+		soa.clear();
+		refs.clear();
+		bbox = aabb::empty;
+
+		motion = !objects.empty();
+		for (const auto& s : moving_spheres) {
+			motion = motion || !s.center_vec.near_zero();
+		}
+
+		lights.clear();
+		light_cdf.clear();
+		sphere_light.clear();
+		env_light = false;
+
+		if (prims.empty()) { return; }
+
+		nodes.reserve(2 * prims.size() / MAX_LEAF_SIZE + 1);
+		build_recursive(prims, 0, prims.size(), 0);
+		bbox = aabb(nodes[0].box0, nodes[0].box1);
+
+		build_lights();
+		soa.pad();
+		sphere_light.resize(soa.radius.size(), -1);
+	}
+
+	// Hit
+	bool Scene::hit(const ray& r, Interval ray_t, hit_record& rec) const {
+		hit_info info;
+		if (!intersect(r, ray_t, info)) { return false; }
+
+		// Only now build the record, and only for the closest hit
+		interaction(r, info, rec);
+		return true;
+	}
+
+	// Intersect
+	bool Scene::intersect(const ray& r, Interval ray_t, hit_info& info) const {
+		if (nodes.empty()) { return false; }
+
+		return traverse(0, r, ray_t, info);
+	}
+
+	// Interaction
+	void Scene::interaction(const ray& r, const hit_info& info, hit_record& rec) const {
+		// Built in spheres are tagged with the scene itself, anything else did its own intersect
+		if (info.object == this) { sphere_record(info.prim, r, info.t, rec); }
+		else {
+			info.object->interaction(r, info, rec);
+			rec.light = -1;
+		}
+	}
+
+	/**
+	* Node Hit
+	* Slab test against a node's box at one time, with the ray's inverse
+	* direction worked out once up front instead of once per box
+	*
+	* @param box0		Box at time 0
+	* @param box1		Box at time 1
+	* @param time		Ray time
+	* @param origin		Ray origin
+	* @param inv_dir	1 / ray direction
+	* @param ray_t		Interval (time) of the ray
+	*
+	* @return Whether the box was hit
+	*/
+	static inline bool node_hit(const aabb& box0, const aabb& box1, real time,
+		const point3& origin, const vec3& inv_dir, Interval ray_t) {
+
+		for (int axis = 0; axis < 3; ++axis) {
+			const Interval& i0 = box0.axis_interval(axis);
+			const Interval& i1 = box1.axis_interval(axis);
+
+			real t0 = (i0.min + time * (i1.min - i0.min) - origin[axis]) * inv_dir[axis];
+			real t1 = (i0.max + time * (i1.max - i0.max) - origin[axis]) * inv_dir[axis];
+
+			ray_t.min = std::max(ray_t.min, std::min(t0, t1));
+			ray_t.max = std::min(ray_t.max, std::max(t0, t1));
+
+			if (ray_t.max < ray_t.min) { return false; }
+		}
+
+		return true;
+	}
+
+	// Occluded
+	bool Scene::occluded(const ray& r, Interval ray_t) const {
+		if (nodes.empty()) { return false; }
+
+		real time = r.time();
+		const point3& origin = r.origin();
+		vec3 inv_dir(1 / r.direction()[0], 1 / r.direction()[1], 1 / r.direction()[2]);
+
+		std::uint32_t stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = 0;
+
+		while (stack_size > 0) {
+			std::uint32_t index = stack[--stack_size];
+			const flat_node& n = nodes[index];
+
+			if (!node_hit(n.box0, n.box1, time, origin, inv_dir, ray_t)) { continue; }
+
+			// Any hit will do, so order doesn't matter
+			if (!n.is_leaf()) {
+				stack[stack_size++] = n.offset;
+				stack[stack_size++] = index + 1;
+				continue;
+			}
+
+			if (n.count > 0) {
+				real t_max = ray_t.max;
+				if (intersect_spheres(soa, n.offset, n.count, r, ray_t.min, t_max) >= 0) { return true; }
+			}
+
+			for (std::uint32_t i = 0; i < n.object_count; ++i) {
+				if (objects[refs[n.object_offset + i].index]->occluded(r, ray_t)) { return true; }
+			}
+		}
+
+		return false;
+	}
+
+	// Hit Packet
+	std::uint64_t Scene::hit_packet(const ray_packet& packet, Interval ray_t, hit_record* recs) const {
+		if (nodes.empty() || packet.size == 0) { return 0; }
+
+		// Per ray closest hit, same as hit() but for every ray at once
+		real t_max[ray_packet::MAX_RAYS];
+		hit_info infos[ray_packet::MAX_RAYS];
+		std::uint64_t hits = 0;
+		for (int i = 0; i < packet.size; ++i) { t_max[i] = ray_t.max; }
+
+		// Nodes left to visit, and which rays are still active in each
+		struct packet_entry {
+			std::uint32_t index;
+			std::uint64_t active;
+		};
+		packet_entry stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = { 0, packet.all() };
+
+		while (stack_size > 0) {
+			packet_entry entry = stack[--stack_size];
+			const flat_node& n = nodes[entry.index];
+
+			// Whole packet first, against the node's box over the packet's time range
+			real far = ray_t.min;
+			for (std::uint64_t m = entry.active; m; m &= m - 1) {
+				far = std::max(far, t_max[lowest_bit(m)]);
+			}
+			aabb swept = (packet.time.min == packet.time.max)
+				? aabb::lerp(n.box0, n.box1, packet.time.min)
+				: aabb(aabb::lerp(n.box0, n.box1, packet.time.min), aabb::lerp(n.box0, n.box1, packet.time.max));
+			if (!packet.may_hit(swept, Interval(ray_t.min, far))) { continue; }
+
+			// Then each ray, only the ones that actually hit the box go on
+			std::uint64_t active = 0;
+			for (std::uint64_t m = entry.active; m; m &= m - 1) {
+				int i = lowest_bit(m);
+				const ray& r = packet.rays[i];
+				if (aabb::lerp(n.box0, n.box1, r.time()).hit(r, Interval(ray_t.min, t_max[i]))) {
+					active |= std::uint64_t(1) << i;
+				}
+			}
+			if (active == 0) { continue; }
+
+			// Packet has fallen apart, finish this subtree one ray at a time
+			if (bit_count(active) <= SINGLE_RAY_THRESHOLD) {
+				for (std::uint64_t m = active; m; m &= m - 1) {
+					int i = lowest_bit(m);
+					Interval t(ray_t.min, t_max[i]);
+					if (traverse(entry.index, packet.rays[i], t, infos[i])) {
+						hits |= std::uint64_t(1) << i;
+					}
+					t_max[i] = t.max;
+				}
+				continue;
+			}
+
+			// Leaf, check every primitive against every active ray
+			if (n.is_leaf()) {
+				for (std::uint64_t m = active; m; m &= m - 1) {
+					int i = lowest_bit(m);
+					const ray& r = packet.rays[i];
+
+					if (n.count > 0) {
+						int sphere = intersect_spheres(soa, n.offset, n.count, r, ray_t.min, t_max[i]);
+						if (sphere >= 0) {
+							infos[i] = { t_max[i], this, std::uint32_t(sphere) };
+							hits |= std::uint64_t(1) << i;
+						}
+					}
+
+					for (std::uint32_t j = 0; j < n.object_count; ++j) {
+						const prim_ref& ref = refs[n.object_offset + j];
+						if (objects[ref.index]->intersect(r, Interval(ray_t.min, t_max[i]), infos[i])) {
+							hits |= std::uint64_t(1) << i;
+							t_max[i] = infos[i].t;
+						}
+					}
+				}
+			}
+			// Interior, near child (for the first active ray) gets popped first
+			else {
+				bool neg = packet.rays[lowest_bit(active)].direction()[n.axis] < 0;
+				std::uint32_t near_child = neg ? n.offset : entry.index + 1;
+				std::uint32_t far_child = neg ? entry.index + 1 : n.offset;
+				stack[stack_size++] = { far_child, active };
+				stack[stack_size++] = { near_child, active };
+			}
+		}
+
+		// Records for just the closest hits
+		for (std::uint64_t m = hits; m; m &= m - 1) {
+			int i = lowest_bit(m);
+			interaction(packet.rays[i], infos[i], recs[i]);
+		}
+
+		return hits;
+	}
+
+	// Cones with sin^2 of their half angle under this (1.5 degrees) are small
+	static const real SMALL_CONE = real(0.00068523);
+
+	/**
+	* Cone One Minus Cos
+	* Tiny or far away lights, 1 - cos would be all rounding error, so
+	* small cones go through sin^2 instead (1 - cos ~ sin^2 / 2)
+	*
+	* @param sin2_max	sin^2 of the cone's half angle
+	*
+	* @return 1 - cos of the cone's half angle
+	*/
+	static real cone_one_minus_cos(real sin2_max) {
+		if (sin2_max < SMALL_CONE) { return sin2_max / 2; }
+		return 1 - std::sqrt(std::fmax(real(0), 1 - sin2_max));
+	}
+
+	// Sample Light
+	bool Scene::sample_light(const point3& p, real time, real u_pick, const vec3& u, light_sample& ls) const {
+		if (light_cdf.empty()) { return false; }
+
+		// Pick by power
+		size_t k = std::min(size_t(std::upper_bound(light_cdf.begin(), light_cdf.end(), u_pick) - light_cdf.begin()), light_cdf.size() - 1);
+		real pick_pdf = light_pick_pdf(k);
+		if (pick_pdf <= 0) { return false; }
+
+		// Environment, straight from its map
+		if (k == lights.size()) {
+			real pdf;
+			ls.emission = env->sample(u, ls.direction, pdf);
+			if (pdf <= 0) { return false; }
+
+			ls.point = p + ls.direction;
+			ls.pdf = pdf * pick_pdf;
+			ls.infinite = true;
+			return true;
+		}
+
+		std::uint32_t index = lights[k];
+		point3 center = soa.center(index, time);
+		real radius = soa.radius[index];
+		real radius2 = radius * radius;
+
+		vec3 to_center = center - p;
+		real dist2 = to_center.length_squared();
+
+		vec3 direction;
+		real distance, pdf;
+		if (dist2 <= radius2) {
+			// Inside the light, no cone to pick from, so any point on the
+			// sphere (it won't be lit from inside anyway, lights are one sided)
+			vec3 on_light = center + radius * sample_unit_vector(u) - p;
+			distance = on_light.length();
+			if (distance == 0) { return false; }
+			direction = on_light / distance;
+
+			real cos_light = std::fabs(dot(direction, unit_vector(on_light + p - center)));
+			if (cos_light == 0) { return false; }
+			pdf = distance * distance / (cos_light * real(4 * PI) * radius2);
+		}
+		else {
+			// Uniform over the cone of directions the sphere covers
+			real dist = std::sqrt(dist2);
+			vec3 axis = to_center / dist;
+
+			real sin2_max = radius2 / dist2;
+			real one_minus_cos_max = cone_one_minus_cos(sin2_max);
+
+			real cos_theta = 1 - u.x() * one_minus_cos_max;
+			real sin2_theta = 1 - cos_theta * cos_theta;
+
+			// Same problem as in cone_one_minus_cos
+			if (sin2_max < SMALL_CONE) {
+				sin2_theta = sin2_max * u.x();
+				cos_theta = std::sqrt(1 - sin2_theta);
+			}
+
+			real sin_theta = std::sqrt(std::fmax(real(0), sin2_theta));
+			real phi = real(2 * PI) * u.y();
+
+			vec3 b1, b2;
+			orthonormal_basis(axis, b1, b2);
+			direction = sin_theta * std::cos(phi) * b1 + sin_theta * std::sin(phi) * b2 + cos_theta * axis;
+
+			// Near side of the sphere along direction
+			real b = dist * cos_theta;
+			distance = b - std::sqrt(std::fmax(real(0), radius2 - dist2 * sin2_theta));
+			pdf = 1 / (real(2 * PI) * one_minus_cos_max);
+		}
+
+		// What the light gives off at the point found
+		ray to_light(p, direction, time);
+		hit_record rec;
+		rec.p = p + distance * direction;
+		rec.t = distance;
+		rec.mat = soa.mat[index];
+		rec.light = std::int32_t(k);
+		rec.set_face_normal(to_light, unit_vector(rec.p - center));
+
+		ls.direction = direction;
+		ls.point = rec.p;
+		ls.emission = materials[rec.mat].emitted(to_light, rec);
+		ls.pdf = pdf * pick_pdf;
+		ls.infinite = false;
+		return true;
+	}
+
+	// Light PDF
+	real Scene::light_pdf(const ray& r, const hit_record& rec) const {
+		if (rec.light < 0) { return 0; }
+
+		std::uint32_t index = lights[rec.light];
+		point3 center = soa.center(index, r.time());
+		real radius2 = soa.radius[index] * soa.radius[index];
+		real dist2 = (center - r.origin()).length_squared();
+
+		// Same two cases as sample_light
+		real pdf;
+		if (dist2 <= radius2) {
+			vec3 to_light = rec.p - r.origin();
+			real cos_light = std::fabs(dot(unit_vector(to_light), rec.normal));
+			if (cos_light == 0) { return 0; }
+			pdf = to_light.length_squared() / (cos_light * real(4 * PI) * radius2);
+		}
+		else {
+			pdf = 1 / (real(2 * PI) * cone_one_minus_cos(radius2 / dist2));
+		}
+
+		return pdf * light_pick_pdf(size_t(rec.light));
+	}
+
+	// Environment PDF
+	real Scene::environment_pdf(const vec3& direction) const {
+		if (!env_light) { return 0; }
+
+		return env->pdf(direction) * light_pick_pdf(lights.size());
+	}
+
+	// Has Lights
+	bool Scene::has_lights() const { return !light_cdf.empty(); }
+
+	// Has Motion
+	bool Scene::has_motion() const { return motion; }
+
+	// Bounding Box
+	aabb Scene::bounding_box() const { return bbox; }
+
+
+
+	// Build Recursive
+	std::uint32_t Scene::build_recursive(std::vector<build_prim>& prims, size_t start, size_t end, int depth) {
+		std::uint32_t index = std::uint32_t(nodes.size());
+		nodes.push_back(flat_node());
+
+		// Bounds of the range, and of the centroids for picking the split
+		aabb box0 = aabb::empty, box1 = aabb::empty, centroid_box = aabb::empty;
+		for (size_t i = start; i < end; ++i) {
+			box0 = aabb(box0, prims[i].box0);
+			box1 = aabb(box1, prims[i].box1);
+			centroid_box = aabb(centroid_box, aabb(prims[i].centroid, prims[i].centroid));
+		}
+
+		size_t span = end - start;
+
+		// Leaf, spheres go into the SoA and everything else into refs
+		if (span <= MAX_LEAF_SIZE) {
+			flat_node& leaf = nodes[index];
+			leaf.box0 = box0;
+			leaf.box1 = box1;
+			leaf.offset = std::uint32_t(soa.radius.size());
+			leaf.object_offset = std::uint32_t(refs.size());
+			leaf.count = 0;
+			leaf.object_count = 0;
+			leaf.axis = 0;
+
+			for (size_t i = start; i < end; ++i) {
+				const prim_ref& ref = prims[i].ref;
+				switch (ref.type) {
+				case prim_type::sphere: {
+					const sphere_prim& s = spheres[ref.index];
+					soa.push_back(s.center, vec3(0, 0, 0), s.radius, s.mat);
+					++leaf.count;
+					break;
+				}
+				case prim_type::moving_sphere: {
+					const moving_sphere_prim& s = moving_spheres[ref.index];
+					soa.push_back(s.center1, s.center_vec, s.radius, s.mat);
+					++leaf.count;
+					break;
+				}
+				default:
+					refs.push_back(ref);
+					++leaf.object_count;
+					break;
+				}
+			}
+
+			return index;
+		}
+
+		// Binned surface area heuristic along the longest (centroid) axis
+		// Areas use the box halfway through the shutter
+		int axis = centroid_box.longest_axis();
+		const Interval& extent = centroid_box.axis_interval(axis);
+
+		size_t mid = start + span / 2;
+
+		if (extent.size() > 0 && depth < MAX_SAH_DEPTH) {
+			const int N_BINS = 16;
+			aabb bin_box[N_BINS];
+			size_t bin_count[N_BINS] = {};
+
+			auto bin_of = [&](const build_prim& p) {
+				int b = int(N_BINS * (p.centroid[axis] - extent.min) / extent.size());
+				return std::min(b, N_BINS - 1);
+			};
+
+			for (int b = 0; b < N_BINS; ++b) { bin_box[b] = aabb::empty; }
+			for (size_t i = start; i < end; ++i) {
+				int b = bin_of(prims[i]);
+				bin_box[b] = aabb(bin_box[b], aabb::lerp(prims[i].box0, prims[i].box1, 0.5));
+				++bin_count[b];
+			}
+
+			// Sweep from the right, then from the left, costing each of the splits
+			double right_area[N_BINS];
+			size_t right_count[N_BINS];
+			aabb sweep = aabb::empty;
+			size_t count = 0;
+			for (int b = N_BINS - 1; b > 0; --b) {
+				sweep = aabb(sweep, bin_box[b]);
+				count += bin_count[b];
+				right_area[b] = count > 0 ? sweep.surface_area() : 0;
+				right_count[b] = count;
+			}
+
+			double best_cost = INF;
+			int best_split = -1;
+			sweep = aabb::empty;
+			count = 0;
+			for (int b = 0; b < N_BINS - 1; ++b) {
+				sweep = aabb(sweep, bin_box[b]);
+				count += bin_count[b];
+				if (count == 0 || right_count[b + 1] == 0) { continue; }
+
+				double cost = count * sweep.surface_area() + right_count[b + 1] * right_area[b + 1];
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_split = b;
+				}
+			}
+
+			if (best_split >= 0) {
+				auto split = std::partition(prims.begin() + start, prims.begin() + end,
+					[&](const build_prim& p) { return bin_of(p) <= best_split; });
+				mid = size_t(split - prims.begin());
+			}
+		}
+
+		// Everything landed in one bin (or too deep for the SAH), fall back to a median split
+		if (mid == start || mid == end || extent.size() <= 0 || depth >= MAX_SAH_DEPTH) {
+			mid = start + span / 2;
+			std::nth_element(prims.begin() + start, prims.begin() + mid, prims.begin() + end,
+				[axis](const build_prim& a, const build_prim& b) {
+					return a.centroid[axis] < b.centroid[axis];
+				});
+		}
+
+		// Left child ends up right after this node
+		build_recursive(prims, start, mid, depth + 1);
+		std::uint32_t right = build_recursive(prims, mid, end, depth + 1);
+
+		flat_node& interior = nodes[index];
+		interior.box0 = box0;
+		interior.box1 = box1;
+		interior.offset = right;
+		interior.object_offset = 0;
+		interior.count = 0;
+		interior.object_count = 0;
+		interior.axis = std::uint8_t(axis);
+
+		return index;
+	}
+
+	// Traverse
+	bool Scene::traverse(std::uint32_t root, const ray& r, Interval& ray_t, hit_info& info) const {
+		real time = r.time();
+		bool dir_is_neg[3] = { r.direction()[0] < 0, r.direction()[1] < 0, r.direction()[2] < 0 };
+
+		// Nodes left to visit, see STACK_SIZE
+		std::uint32_t stack[STACK_SIZE];
+		int stack_size = 0;
+		std::uint32_t index = root;
+
+		bool hit_anything = false;
+
+		while (true) {
+			const flat_node& n = nodes[index];
+
+			if (aabb::lerp(n.box0, n.box1, time).hit(r, ray_t)) {
+				// Leaf, check every primitive
+				if (n.is_leaf()) {
+					if (n.count > 0) {
+						int sphere = intersect_spheres(soa, n.offset, n.count, r, ray_t.min, ray_t.max);
+						if (sphere >= 0) {
+							info = { ray_t.max, this, std::uint32_t(sphere) };
+							hit_anything = true;
+						}
+					}
+
+					for (std::uint32_t i = 0; i < n.object_count; ++i) {
+						const prim_ref& ref = refs[n.object_offset + i];
+						if (objects[ref.index]->intersect(r, ray_t, info)) {
+							hit_anything = true;
+							ray_t.max = info.t;
+						}
+					}
+
+					if (stack_size == 0) { break; }
+					index = stack[--stack_size];
+				}
+				// Interior, visit the near child first
+				else {
+					if (dir_is_neg[n.axis]) {
+						stack[stack_size++] = index + 1;
+						index = n.offset;
+					}
+					else {
+						stack[stack_size++] = n.offset;
+						index = index + 1;
+					}
+				}
+			}
+			else {
+				if (stack_size == 0) { break; }
+				index = stack[--stack_size];
+			}
+		}
+
+		return hit_anything;
+	}
+
+	// Build Lights
+	void Scene::build_lights() {
+		sphere_light.assign(soa.radius.size(), -1);
+
+		// Power ~ luminance * surface area
+		std::vector<double> power;
+		double total = 0;
+		for (std::uint32_t i = 0; i < soa.radius.size(); ++i) {
+			if (materials.kind(soa.mat[i]) != material_kind::light) { continue; }
+
+			const color& e = static_cast<const diffuse_light&>(materials[soa.mat[i]]).radiance();
+			double luminance = 0.2126 * e.x() + 0.7152 * e.y() + 0.0722 * e.z();
+			double area = 4 * PI * soa.radius[i] * soa.radius[i];
+			if (luminance <= 0 || area <= 0) { continue; }
+
+			sphere_light[i] = std::int32_t(lights.size());
+			lights.push_back(i);
+			power.push_back(luminance * area);
+			total += luminance * area;
+		}
+
+		// Environment, weighed like a sphere light around the whole scene
+		// giving off its average radiance (power() * r^2 = luminance * 4 pi r^2)
+		if (env && env->power() > 0) {
+			vec3 extent(bbox.x.size(), bbox.y.size(), bbox.z.size());
+			double radius2 = 0.25 * extent.length_squared();
+			double env_power = env->power() * std::fmax(radius2, 1.0);
+
+			env_light = true;
+			power.push_back(env_power);
+			total += env_power;
+		}
+
+		double sum = 0;
+		for (double w : power) {
+			sum += w;
+			light_cdf.push_back(real(sum / total));
+		}
+		if (!light_cdf.empty()) { light_cdf.back() = 1; }
+	}
+
+	// Light Pick PDF
+	real Scene::light_pick_pdf(size_t k) const {
+		return light_cdf[k] - (k > 0 ? light_cdf[k - 1] : real(0));
+	}
+
+	// Sphere Record
+	void Scene::sphere_record(std::uint32_t index, const ray& r, real t, hit_record& rec) const {
+		point3 center = soa.center(index, r.time());
+
+		// Pushed back onto the surface, see Sphere::hit
+		rec.t = t;
+		vec3 outward_normal = unit_vector(r.at(t) - center);
+		vec3 radial = soa.radius[index] * outward_normal;
+		rec.p = center + radial;
+		rec.p_error = gamma_bound<real>(6) * (abs(center) + abs(radial));
+		rec.set_face_normal(r, outward_normal);
+		rec.mat = soa.mat[index];
+		rec.light = sphere_light[index];
+	}
+
+}
@@ -0,0 +1,196 @@
+// sphere_kernel.cpp - Implementation of the sphere_soa struct and the SIMD sphere kernel
+// Ethan Rudy
+
+#include "../../include/rtw/sphere_kernel.h"
+#include <type_traits>
+
+#ifdef RTW_X86
+#include <immintrin.h>
+#include "../../include/rtw/sphere_kernel_simd.h"
+#endif
+
+namespace rtw {
+
+	// Push Back
+	void sphere_soa::push_back(const point3& center, const vec3& velocity, real r, mat_id m) {
+		cx.push_back(center.x());
+		cy.push_back(center.y());
+		cz.push_back(center.z());
+		vx.push_back(velocity.x());
+		vy.push_back(velocity.y());
+		vz.push_back(velocity.z());
+		radius.push_back(r);
+		mat.push_back(m);
+	}
+
+	// Pad
+	void sphere_soa::pad() {
+		for (int i = 0; i < PADDING; ++i) {
+			push_back(point3(0, 0, 0), vec3(0, 0, 0), 0, 0);
+		}
+	}
+
+	// Clear
+	void sphere_soa::clear() {
+		cx.clear(); cy.clear(); cz.clear();
+		vx.clear(); vy.clear(); vz.clear();
+		radius.clear();
+		mat.clear();
+	}
+
+	// Center
+	point3 sphere_soa::center(std::uint32_t i, real time) const {
+		return point3(cx[i] + time * vx[i], cy[i] + time * vy[i], cz[i] + time * vz[i]);
+	}
+
+
+
+#ifdef RTW_X86
+
+	namespace {
+
+		// SSE2, 2 doubles
+		// No blendv before SSE4.1, select is done with and/andnot/or
+		struct simd_sse2_double {
+			using scalar = double;
+			using reg = __m128d;
+			using mask = __m128d;
+			static const int WIDTH = 2;
+
+			static reg set1(double x) { return _mm_set1_pd(x); }
+			static reg load(const double* p) { return _mm_loadu_pd(p); }
+			static void store(double* p, reg a) { _mm_storeu_pd(p, a); }
+			static reg lanes() { return _mm_set_pd(1, 0); }
+			static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+			static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+			static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+			static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+			static reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+			static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+			static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+			static mask lt(reg a, reg b) { return _mm_cmplt_pd(a, b); }
+			static mask gt(reg a, reg b) { return _mm_cmpgt_pd(a, b); }
+			static mask ge(reg a, reg b) { return _mm_cmpge_pd(a, b); }
+			static mask both(mask a, mask b) { return _mm_and_pd(a, b); }
+			static reg select(mask m, reg if_true, reg if_false) {
+				return _mm_or_pd(_mm_and_pd(m, if_true), _mm_andnot_pd(m, if_false));
+			}
+			static bool any(mask m) { return _mm_movemask_pd(m) != 0; }
+
+			// Magnitude of a with the sign of b
+			static reg copysign(reg a, reg b) {
+				const reg sign = _mm_set1_pd(-0.0);
+				return _mm_or_pd(_mm_andnot_pd(sign, a), _mm_and_pd(sign, b));
+			}
+		};
+
+		// SSE2, 4 floats
+		struct simd_sse2_float {
+			using scalar = float;
+			using reg = __m128;
+			using mask = __m128;
+			static const int WIDTH = 4;
+
+			static reg set1(float x) { return _mm_set1_ps(x); }
+			static reg load(const float* p) { return _mm_loadu_ps(p); }
+			static void store(float* p, reg a) { _mm_storeu_ps(p, a); }
+			static reg lanes() { return _mm_set_ps(3, 2, 1, 0); }
+			static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+			static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+			static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+			static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+			static reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+			static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+			static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+			static mask lt(reg a, reg b) { return _mm_cmplt_ps(a, b); }
+			static mask gt(reg a, reg b) { return _mm_cmpgt_ps(a, b); }
+			static mask ge(reg a, reg b) { return _mm_cmpge_ps(a, b); }
+			static mask both(mask a, mask b) { return _mm_and_ps(a, b); }
+			static reg select(mask m, reg if_true, reg if_false) {
+				return _mm_or_ps(_mm_and_ps(m, if_true), _mm_andnot_ps(m, if_false));
+			}
+			static bool any(mask m) { return _mm_movemask_ps(m) != 0; }
+
+			// Magnitude of a with the sign of b
+			static reg copysign(reg a, reg b) {
+				const reg sign = _mm_set1_ps(-0.0f);
+				return _mm_or_ps(_mm_andnot_ps(sign, a), _mm_and_ps(sign, b));
+			}
+		};
+
+		using simd = std::conditional<std::is_same<real, float>::value, simd_sse2_float, simd_sse2_double>::type;
+	}
+
+	// Intersect Spheres (SSE2)
+	int intersect_spheres_sse2(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max) {
+		return intersect_spheres_simd<simd>(s, first, count, r, t_min, t_max);
+	}
+
+#endif
+
+	// Intersect Spheres (Scalar)
+	// One sphere at a time, same math as Sphere::hit minus the hit record
+	int intersect_spheres_scalar(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max) {
+
+		const point3& o = r.origin();
+		const vec3& d = r.direction();
+		real time = r.time();
+		real a = d.length_squared();
+
+		int best = -1;
+		for (std::uint32_t i = first; i < first + count; ++i) {
+			vec3 oc(s.cx[i] + time * s.vx[i] - o[0], s.cy[i] + time * s.vy[i] - o[1], s.cz[i] + time * s.vz[i] - o[2]);
+			real rad2 = s.radius[i] * s.radius[i];
+
+			real h = dot(d, oc);
+			real c = oc.length_squared() - rad2;
+			real discriminant = a * (rad2 - (oc - (h / a) * d).length_squared());
+
+			if (discriminant < 0) { continue; }
+
+			real q = h + std::copysign(std::sqrt(discriminant), h);
+			real root0 = c / q, root1 = q / a;
+			real root = std::fmin(root0, root1);
+			if (root <= t_min || t_max <= root) {
+				root = std::fmax(root0, root1);
+				if (root <= t_min || t_max <= root) { continue; }
+			}
+
+			t_max = root;
+			best = int(i);
+		}
+
+		return best;
+	}
+
+
+
+	// Kernel signature, all of the above share it
+	using intersect_spheres_fn = int (*)(const sphere_soa&, std::uint32_t, std::uint32_t, const ray&, real, real&);
+
+	/**
+	* Select Kernel
+	*
+	* @return Widest version of the kernel the host CPU can run
+	*/
+	static intersect_spheres_fn select_kernel() {
+		switch (host_simd_level()) {
+#ifdef RTW_X86
+		case simd_level::avx512: return intersect_spheres_avx512;
+		case simd_level::avx2: return intersect_spheres_avx2;
+		case simd_level::sse2: return intersect_spheres_sse2;
+#endif
+		default: return intersect_spheres_scalar;
+		}
+	}
+
+	// Intersect Spheres
+	int intersect_spheres(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max) {
+		static const intersect_spheres_fn kernel = select_kernel();
+		return kernel(s, first, count, r, t_min, t_max);
+	}
+
+}
@@ -0,0 +1,102 @@
+// sphere_kernel_avx2.cpp - AVX2 version of the SIMD sphere kernel
+// Ethan Rudy
+
+#include "../../include/rtw/sphere_kernel.h"
+#include <type_traits>
+
+#ifdef RTW_X86
+#include <immintrin.h>
+
+// Everything below is built for AVX2 + FMA (Haswell, Zen), only ever
+// called once host_simd_level() says the CPU has them
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#include "../../include/rtw/sphere_kernel_simd.h"
+
+namespace rtw {
+
+	namespace {
+
+		// AVX, 4 doubles
+		struct simd_avx2_double {
+			using scalar = double;
+			using reg = __m256d;
+			using mask = __m256d;
+			static const int WIDTH = 4;
+
+			static reg set1(double x) { return _mm256_set1_pd(x); }
+			static reg load(const double* p) { return _mm256_loadu_pd(p); }
+			static void store(double* p, reg a) { _mm256_storeu_pd(p, a); }
+			static reg lanes() { return _mm256_set_pd(3, 2, 1, 0); }
+			static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+			static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+			static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+			static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+			static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+			static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+			static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+			static mask lt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+			static mask gt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+			static mask ge(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+			static mask both(mask a, mask b) { return _mm256_and_pd(a, b); }
+			static reg select(mask m, reg if_true, reg if_false) { return _mm256_blendv_pd(if_false, if_true, m); }
+			static bool any(mask m) { return _mm256_movemask_pd(m) != 0; }
+
+			// Magnitude of a with the sign of b
+			static reg copysign(reg a, reg b) {
+				const reg sign = _mm256_set1_pd(-0.0);
+				return _mm256_or_pd(_mm256_andnot_pd(sign, a), _mm256_and_pd(sign, b));
+			}
+		};
+
+		// AVX, 8 floats
+		struct simd_avx2_float {
+			using scalar = float;
+			using reg = __m256;
+			using mask = __m256;
+			static const int WIDTH = 8;
+
+			static reg set1(float x) { return _mm256_set1_ps(x); }
+			static reg load(const float* p) { return _mm256_loadu_ps(p); }
+			static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+			static reg lanes() { return _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0); }
+			static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+			static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+			static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+			static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+			static reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+			static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+			static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+			static mask lt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static mask gt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+			static mask ge(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+			static mask both(mask a, mask b) { return _mm256_and_ps(a, b); }
+			static reg select(mask m, reg if_true, reg if_false) { return _mm256_blendv_ps(if_false, if_true, m); }
+			static bool any(mask m) { return _mm256_movemask_ps(m) != 0; }
+
+			// Magnitude of a with the sign of b
+			static reg copysign(reg a, reg b) {
+				const reg sign = _mm256_set1_ps(-0.0f);
+				return _mm256_or_ps(_mm256_andnot_ps(sign, a), _mm256_and_ps(sign, b));
+			}
+		};
+
+		using simd = std::conditional<std::is_same<real, float>::value, simd_avx2_float, simd_avx2_double>::type;
+	}
+
+	// Intersect Spheres (AVX2)
+	int intersect_spheres_avx2(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max) {
+		return intersect_spheres_simd<simd>(s, first, count, r, t_min, t_max);
+	}
+
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+// sphere_kernel_avx512.cpp - AVX-512 version of the SIMD sphere kernel
+// Ethan Rudy
+
+#include "../../include/rtw/sphere_kernel.h"
+#include <type_traits>
+
+#ifdef RTW_X86
+#include <immintrin.h>
+
+// Everything below is built for AVX-512F (Skylake-X and up), only ever
+// called once host_simd_level() says the CPU has it
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#endif
+
+// GCC 12's avx512fintrin.h trips -Wmaybe-uninitialized on its own
+// _mm512_undefined_* placeholders (fixed in GCC 13)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include "../../include/rtw/sphere_kernel_simd.h"
+
+namespace rtw {
+
+	namespace {
+
+		// AVX-512, 8 doubles
+		// Compares give bit masks rather than vectors, and the float
+		// and/or/andnot need AVX-512DQ, so copysign goes through integers
+		struct simd_avx512_double {
+			using scalar = double;
+			using reg = __m512d;
+			using mask = __mmask8;
+			static const int WIDTH = 8;
+
+			static reg set1(double x) { return _mm512_set1_pd(x); }
+			static reg load(const double* p) { return _mm512_loadu_pd(p); }
+			static void store(double* p, reg a) { _mm512_storeu_pd(p, a); }
+			static reg lanes() { return _mm512_set_pd(7, 6, 5, 4, 3, 2, 1, 0); }
+			static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+			static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+			static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+			static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+			static reg sqrt(reg a) { return _mm512_sqrt_pd(a); }
+			static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+			static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+			static mask lt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+			static mask gt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+			static mask ge(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+			static mask both(mask a, mask b) { return mask(a & b); }
+			static reg select(mask m, reg if_true, reg if_false) { return _mm512_mask_blend_pd(m, if_false, if_true); }
+			static bool any(mask m) { return m != 0; }
+
+			// Magnitude of a with the sign of b
+			static reg copysign(reg a, reg b) {
+				const __m512i sign = _mm512_set1_epi64(std::int64_t(1) << 63);
+				__m512i mag = _mm512_andnot_si512(sign, _mm512_castpd_si512(a));
+				return _mm512_castsi512_pd(_mm512_or_si512(mag, _mm512_and_si512(sign, _mm512_castpd_si512(b))));
+			}
+		};
+
+		// AVX-512, 16 floats
+		struct simd_avx512_float {
+			using scalar = float;
+			using reg = __m512;
+			using mask = __mmask16;
+			static const int WIDTH = 16;
+
+			static reg set1(float x) { return _mm512_set1_ps(x); }
+			static reg load(const float* p) { return _mm512_loadu_ps(p); }
+			static void store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+			static reg lanes() { return _mm512_set_ps(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0); }
+			static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+			static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+			static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+			static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+			static reg sqrt(reg a) { return _mm512_sqrt_ps(a); }
+			static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+			static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+			static mask lt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+			static mask gt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+			static mask ge(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+			static mask both(mask a, mask b) { return mask(a & b); }
+			static reg select(mask m, reg if_true, reg if_false) { return _mm512_mask_blend_ps(m, if_false, if_true); }
+			static bool any(mask m) { return m != 0; }
+
+			// Magnitude of a with the sign of b
+			static reg copysign(reg a, reg b) {
+				const __m512i sign = _mm512_set1_epi32(std::int32_t(0x80000000u));
+				__m512i mag = _mm512_andnot_si512(sign, _mm512_castps_si512(a));
+				return _mm512_castsi512_ps(_mm512_or_si512(mag, _mm512_and_si512(sign, _mm512_castps_si512(b))));
+			}
+		};
+
+		using simd = std::conditional<std::is_same<real, float>::value, simd_avx512_float, simd_avx512_double>::type;
+	}
+
+	// Intersect Spheres (AVX-512)
+	int intersect_spheres_avx512(const sphere_soa& s, std::uint32_t first, std::uint32_t count,
+		const ray& r, real t_min, real& t_max) {
+		return intersect_spheres_simd<simd>(s, first, count, r, t_min, t_max);
+	}
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#endif
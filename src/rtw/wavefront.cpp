@@ -0,0 +1,306 @@
+// wavefront.cpp - Implementation of the Wavefront class
+// Ethan Rudy
+
+#include "../../include/rtw/wavefront.h"
+#include "../../include/rtw/camera.h"
+#include <algorithm>
+
+namespace rtw {
+
+	// Default Constructor
+	Wavefront::Wavefront() {
+		ox.reserve(BATCH_SIZE); oy.reserve(BATCH_SIZE); oz.reserve(BATCH_SIZE);
+		dx.reserve(BATCH_SIZE); dy.reserve(BATCH_SIZE); dz.reserve(BATCH_SIZE);
+		time.reserve(BATCH_SIZE);
+		tr.reserve(BATCH_SIZE); tg.reserve(BATCH_SIZE); tb.reserve(BATCH_SIZE);
+		lr.reserve(BATCH_SIZE); lg.reserve(BATCH_SIZE); lb.reserve(BATCH_SIZE);
+		bsdf_pdf.reserve(BATCH_SIZE);
+		pixel.reserve(BATCH_SIZE);
+		pixel_x.reserve(BATCH_SIZE); pixel_y.reserve(BATCH_SIZE);
+		sample_index.reserve(BATCH_SIZE); sample_dim.reserve(BATCH_SIZE);
+	}
+
+	// Clear
+	void Wavefront::clear() {
+		ox.clear(); oy.clear(); oz.clear();
+		dx.clear(); dy.clear(); dz.clear();
+		time.clear();
+		tr.clear(); tg.clear(); tb.clear();
+		lr.clear(); lg.clear(); lb.clear();
+		bsdf_pdf.clear();
+		pixel.clear();
+		pixel_x.clear(); pixel_y.clear();
+		sample_index.clear(); sample_dim.clear();
+	}
+
+	// Add Path
+	void Wavefront::add(const ray& r, std::uint32_t p, int x, int y, int sample, int dimension) {
+		ox.push_back(r.origin()[0]); oy.push_back(r.origin()[1]); oz.push_back(r.origin()[2]);
+		dx.push_back(r.direction()[0]); dy.push_back(r.direction()[1]); dz.push_back(r.direction()[2]);
+		time.push_back(r.time());
+		tr.push_back(1); tg.push_back(1); tb.push_back(1);
+		lr.push_back(0); lg.push_back(0); lb.push_back(0);
+		bsdf_pdf.push_back(0);
+		pixel.push_back(p);
+		pixel_x.push_back(std::uint32_t(x)); pixel_y.push_back(std::uint32_t(y));
+		sample_index.push_back(std::uint32_t(sample)); sample_dim.push_back(std::uint32_t(dimension));
+	}
+
+	// Size
+	size_t Wavefront::size() const {
+		return pixel.size();
+	}
+
+	// Trace
+	void Wavefront::trace(const Scene& world, int max_depth, int roulette_depth, real footprint, Sampler& sampler, color* pixel_colors,
+		color* pixel_albedo, vec3* pixel_normal) {
+		// Paths still around after max_depth bounces add nothing, same as ray_color
+		for (int depth = max_depth; depth > 0 && size() > 0; --depth) {
+			// Camera rays are already in tile order
+			if (reorder && depth < max_depth) { reorder_paths(); }
+
+			// Only camera rays have a footprint (and features), bounces look up the sharp map
+			bool camera_rays = depth == max_depth;
+			intersect(world, camera_rays ? footprint : real(0), pixel_colors,
+				camera_rays ? pixel_albedo : nullptr, camera_rays ? pixel_normal : nullptr);
+			sort(world.materials);
+
+			// Bounces taken once this one's done, same count as Camera::hit_color
+			bool roulette = max_depth - depth + 1 >= roulette_depth;
+			bool last = depth == 1;
+
+			shade<lambertian>(world, material_kind::lambertian, roulette, last, sampler, pixel_colors);
+			shade<metal>(world, material_kind::metal, roulette, last, sampler, pixel_colors);
+			shade<dielectric>(world, material_kind::dielectric, roulette, last, sampler, pixel_colors);
+			shade<diffuse_light>(world, material_kind::light, roulette, last, sampler, pixel_colors);
+			shade<material>(world, material_kind::other, roulette, last, sampler, pixel_colors);
+
+			compact();
+		}
+
+		// Out of bounces, keep what they picked up on the way
+		for (size_t i = 0; i < size(); ++i) {
+			pixel_colors[pixel[i]] += color(lr[i], lg[i], lb[i]);
+		}
+
+		clear();
+	}
+
+
+
+	// Path Ray
+	ray Wavefront::path_ray(size_t i) const {
+		return ray(point3(ox[i], oy[i], oz[i]), vec3(dx[i], dy[i], dz[i]), time[i]);
+	}
+
+	/**
+	* Spread Bits
+	* Puts a zero bit between every bit of a 9 bit value, twice
+	*
+	* @param v	Value, only the low 9 bits are used
+	*
+	* @return v's bits at every third position
+	*/
+	static std::uint32_t spread_bits(std::uint32_t v) {
+		v &= 0x1ff;
+		v = (v | (v << 16)) & 0x030000ff;
+		v = (v | (v << 8)) & 0x0300f00f;
+		v = (v | (v << 4)) & 0x030c30c3;
+		v = (v | (v << 2)) & 0x09249249;
+		return v;
+	}
+
+	// Reorder
+	void Wavefront::reorder_paths() {
+		size_t n = size();
+		if (n < 2) { return; }
+
+		// Origin bounds of this batch, the scene's can be far bigger
+		// than where the paths actually are (ground spheres)
+		Interval bounds[3] = { Interval::empty, Interval::empty, Interval::empty };
+		const std::vector<real>* origin[3] = { &ox, &oy, &oz };
+		for (int axis = 0; axis < 3; ++axis) {
+			const std::vector<real>& o = *origin[axis];
+			auto range = std::minmax_element(o.begin(), o.end());
+			bounds[axis] = Interval(*range.first, *range.second);
+		}
+
+		// Key is 3 octant bits over a 27 bit Morton code (512 cells an axis)
+		keys.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			std::uint32_t octant = (dx[i] < 0 ? 4u : 0u) | (dy[i] < 0 ? 2u : 0u) | (dz[i] < 0 ? 1u : 0u);
+
+			std::uint32_t morton = 0;
+			for (int axis = 0; axis < 3; ++axis) {
+				real extent = bounds[axis].size();
+				real u = extent > 0 ? ((*origin[axis])[i] - bounds[axis].min) / extent : 0;
+				std::uint32_t cell = std::min(std::uint32_t(u * 512), 511u);
+				morton |= spread_bits(cell) << (2 - axis);
+			}
+
+			keys[i] = (std::uint64_t((octant << 27) | morton) << 32) | i;
+		}
+
+		std::sort(keys.begin(), keys.end());
+
+		// Gather every array into the new order
+		auto gather = [&](std::vector<real>& v) {
+			scratch.resize(n);
+			for (size_t i = 0; i < n; ++i) { scratch[i] = v[std::uint32_t(keys[i])]; }
+			v.swap(scratch);
+		};
+		gather(ox); gather(oy); gather(oz);
+		gather(dx); gather(dy); gather(dz);
+		gather(time);
+		gather(tr); gather(tg); gather(tb);
+		gather(lr); gather(lg); gather(lb);
+		gather(bsdf_pdf);
+
+		auto gather_index = [&](std::vector<std::uint32_t>& v) {
+			scratch_index.resize(n);
+			for (size_t i = 0; i < n; ++i) { scratch_index[i] = v[std::uint32_t(keys[i])]; }
+			v.swap(scratch_index);
+		};
+		gather_index(pixel);
+		gather_index(pixel_x); gather_index(pixel_y);
+		gather_index(sample_index); gather_index(sample_dim);
+	}
+
+	// Intersect
+	void Wavefront::intersect(const Scene& world, real footprint, color* pixel_colors, color* pixel_albedo, vec3* pixel_normal) {
+		size_t n = size();
+		recs.resize(n);
+		alive.resize(n);
+
+		for (size_t i = 0; i < n; ++i) {
+			// No t epsilon, see Camera::ray_color
+			ray r = path_ray(i);
+			alive[i] = world.hit(r, Interval(0, INF), recs[i]);
+
+			if (pixel_albedo) {
+				color albedo;
+				vec3 normal;
+				Camera::first_hit_features(world, r, alive[i] ? &recs[i] : nullptr, albedo, normal);
+				pixel_albedo[pixel[i]] += albedo;
+				pixel_normal[pixel[i]] += normal;
+			}
+
+			if (!alive[i]) {
+				pixel_colors[pixel[i]] += color(lr[i], lg[i], lb[i]) + color(tr[i], tg[i], tb[i]) * Camera::sky_color(world, r, bsdf_pdf[i], footprint);
+			}
+		}
+	}
+
+	// Sort
+	void Wavefront::sort(const MaterialTable& materials) {
+		const size_t N_KINDS = size_t(material_kind::count);
+		size_t n = size();
+
+		// Count each kind, then prefix sum into where each kind starts
+		size_t counts[N_KINDS] = {};
+		for (size_t i = 0; i < n; ++i) {
+			if (alive[i]) { ++counts[size_t(materials.kind(recs[i].mat))]; }
+		}
+
+		kind_start[0] = 0;
+		for (size_t k = 0; k < N_KINDS; ++k) { kind_start[k + 1] = kind_start[k] + counts[k]; }
+
+		size_t next[N_KINDS];
+		for (size_t k = 0; k < N_KINDS; ++k) { next[k] = kind_start[k]; }
+
+		order.resize(kind_start[N_KINDS]);
+		for (size_t i = 0; i < n; ++i) {
+			if (alive[i]) { order[next[size_t(materials.kind(recs[i].mat))]++] = std::uint32_t(i); }
+		}
+	}
+
+	// Shade
+	template <typename M>
+	void Wavefront::shade(const Scene& world, material_kind kind, bool roulette, bool last, Sampler& sampler, color* pixel_colors) {
+		const MaterialTable& materials = world.materials;
+
+		for (size_t j = kind_start[size_t(kind)]; j < kind_start[size_t(kind) + 1]; ++j) {
+			std::uint32_t i = order[j];
+			const hit_record& rec = recs[i];
+			ray r = path_ray(i);
+
+			// M is final (or material itself for kind 'other'), so this
+			// only goes through the vtable when it has to
+			const M& mat = static_cast<const M&>(materials[rec.mat]);
+
+			// Pick the path's sample up where its last bounce left it
+			sampler.start_pixel_sample(int(pixel_x[i]), int(pixel_y[i]), int(sample_index[i]), int(sample_dim[i]));
+
+			// Same order as Camera::hit_color: emission, lights, then scatter
+			color throughput(tr[i], tg[i], tb[i]);
+			color radiance(lr[i], lg[i], lb[i]);
+			radiance += throughput * Camera::emitted_light(world, r, rec, mat, bsdf_pdf[i]);
+
+			const PathGuide* guided = Camera::bounce_guide(world, guide, rec);
+
+			bool direct = Camera::samples_lights(world, mat);
+			if (direct) {
+				radiance += throughput * Camera::direct_light(world, r, rec, sampler, guided, last);
+			}
+
+			ray scattered;
+			color attenuation;
+			real pdf = 0;
+			bool scatters = guided ? Camera::guided_scatter(*guided, r, rec, mat, attenuation, scattered, pdf, sampler)
+				: mat.scatter(r, rec, attenuation, scattered, sampler);
+			if (!scatters) {
+				// No material == void (or a light)
+				pixel_colors[pixel[i]] += radiance;
+				alive[i] = 0;
+				continue;
+			}
+
+			if (direct && !guided) { pdf = mat.pdf(r, rec, unit_vector(scattered.direction())); }
+			bsdf_pdf[i] = direct ? pdf : 0;
+
+			throughput = throughput * attenuation;
+			if (roulette && !Camera::russian_roulette(throughput, sampler.get_1d())) {
+				pixel_colors[pixel[i]] += radiance;
+				alive[i] = 0;
+				continue;
+			}
+
+			tr[i] = throughput[0]; tg[i] = throughput[1]; tb[i] = throughput[2];
+			lr[i] = radiance[0]; lg[i] = radiance[1]; lb[i] = radiance[2];
+			sample_dim[i] = std::uint32_t(sampler.dimension());
+			ox[i] = scattered.origin()[0]; oy[i] = scattered.origin()[1]; oz[i] = scattered.origin()[2];
+			dx[i] = scattered.direction()[0]; dy[i] = scattered.direction()[1]; dz[i] = scattered.direction()[2];
+		}
+	}
+
+	// Compact
+	void Wavefront::compact() {
+		size_t n = size(), live = 0;
+
+		for (size_t i = 0; i < n; ++i) {
+			if (!alive[i]) { continue; }
+
+			ox[live] = ox[i]; oy[live] = oy[i]; oz[live] = oz[i];
+			dx[live] = dx[i]; dy[live] = dy[i]; dz[live] = dz[i];
+			time[live] = time[i];
+			tr[live] = tr[i]; tg[live] = tg[i]; tb[live] = tb[i];
+			lr[live] = lr[i]; lg[live] = lg[i]; lb[live] = lb[i];
+			bsdf_pdf[live] = bsdf_pdf[i];
+			pixel[live] = pixel[i];
+			pixel_x[live] = pixel_x[i]; pixel_y[live] = pixel_y[i];
+			sample_index[live] = sample_index[i]; sample_dim[live] = sample_dim[i];
+			++live;
+		}
+
+		ox.resize(live); oy.resize(live); oz.resize(live);
+		dx.resize(live); dy.resize(live); dz.resize(live);
+		time.resize(live);
+		tr.resize(live); tg.resize(live); tb.resize(live);
+		lr.resize(live); lg.resize(live); lb.resize(live);
+		bsdf_pdf.resize(live);
+		pixel.resize(live);
+		pixel_x.resize(live); pixel_y.resize(live);
+		sample_index.resize(live); sample_dim.resize(live);
+	}
+
+}